@@ -0,0 +1,257 @@
+// Front-end and execution throughput benchmark.
+//
+// Build against the interpreter sources, e.g.
+//   g++ -std=c++17 -O2 -pthread bench/bench.cpp src/lexer.cpp src/parser.cpp
+//       src/scan.cpp src/resolver.cpp src/compiler.cpp src/vm.cpp src/output.cpp
+//       src/intern.cpp src/string_object.cpp src/closure.cpp
+//       src/stats.cpp -o simplelang-bench
+//
+//   simplelang-bench [--shape all|expr|block|literals|ifs|locals] [--size BYTES] [--iterations N]
+//                    [--lex-threads N]
+//
+// Each shape generates a synthetic program of roughly --size bytes. Every
+// phase is run --iterations times and the fastest run is reported.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/closure.h"
+#include "../src/lexer.h"
+#include "../src/parser.h"
+#include "../src/interpreter.h"
+#include "../src/compiler.h"
+#include "../src/vm.h"
+#include "../src/resolver.h"
+#include "../src/stats.h"
+
+// Deeply nested arithmetic: ((((1 + 2) * 3) - 4) ...) repeated per statement.
+static std::string deepExpressions(size_t size, std::mt19937& rng) {
+    static const char ops[] = {'+', '-', '*'};
+    std::string out;
+    while (out.size() < size) {
+        std::string expr = std::to_string(rng() % 100 + 1);
+        for (int depth = 0; depth < 64; depth++) {
+            expr = "(" + expr + " " + ops[rng() % 3] + " " + std::to_string(rng() % 100 + 1) + ")";
+        }
+        out += expr + ";\n";
+    }
+    return out;
+}
+
+// Blocks holding thousands of short statements.
+static std::string longBlocks(size_t size, std::mt19937& rng) {
+    std::string out;
+    while (out.size() < size) {
+        out += "{\n";
+        for (int i = 0; i < 4096 && out.size() < size; i++) {
+            out += "    " + std::to_string(rng() % 1000) + " * " + std::to_string(rng() % 1000 + 1) + ";\n";
+        }
+        out += "}\n";
+    }
+    return out;
+}
+
+// Flat lists of number and string literals.
+static std::string manyLiterals(size_t size, std::mt19937& rng) {
+    std::string out;
+    while (out.size() < size) {
+        if (rng() % 2) {
+            out += std::to_string(rng() % 100000) + "." + std::to_string(rng() % 1000) + ";\n";
+        } else {
+            out += "\"literal string number " + std::to_string(rng()) + "\";\n";
+        }
+    }
+    return out;
+}
+
+// Nested ifs whose conditions are always true, so every node is executed.
+static std::string nestedIfs(size_t size, std::mt19937& rng) {
+    std::string out;
+    while (out.size() < size) {
+        int depth = 32;
+        for (int i = 0; i < depth; i++) {
+            out += "if " + std::to_string(rng() % 100) + " < " + std::to_string(rng() % 100 + 100) + " {\n";
+        }
+        out += std::to_string(rng() % 10) + " + 1;\n";
+        for (int i = 0; i < depth; i++) {
+            out += "}\n";
+        }
+    }
+    return out;
+}
+
+// Arithmetic and comparisons on a handful of variables, the shapes the VM
+// runs as superinstructions.
+static std::string localArithmetic(size_t size, std::mt19937& rng) {
+    static const char* ops[] = {"+", "-", "*"};
+    std::string out;
+    for (int i = 0; i < 8; i++) {
+        out += "var v" + std::to_string(i) + " = " + std::to_string(rng() % 10) + ";\n";
+    }
+    auto var = [&] { return "v" + std::to_string(rng() % 8); };
+    while (out.size() < size) {
+        switch (rng() % 3) {
+            case 0: out += var() + " = " + var() + " " + ops[rng() % 3] + " " + var() + ";\n"; break;
+            case 1: out += var() + " = " + var() + " " + ops[rng() % 3] + " " + std::to_string(rng() % 10) + ";\n"; break;
+            default: out += "if " + var() + " < " + std::to_string(rng() % 100) + " { " + var() + " = 1; }\n"; break;
+        }
+    }
+    return out;
+}
+
+static double bestSeconds(int iterations, const std::function<void()>& body) {
+    double best = 1e300;
+    for (int i = 0; i < iterations; i++) {
+        auto begin = std::chrono::steady_clock::now();
+        body();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        if (elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+static void report(const std::string& shape, const std::string& phase, double seconds, double amount, const char* unit, double bytes) {
+    std::cout << std::left << std::setw(10) << shape << std::setw(12) << phase
+              << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds * 1000 << " ms"
+              << std::setw(14) << std::setprecision(2) << amount / seconds / 1e6 << " M" << unit << "/s";
+    if (bytes > 0) {
+        std::cout << std::setw(10) << bytes / seconds / (1024 * 1024) << " MB/s";
+    }
+    std::cout << "\n";
+}
+
+static void run(const std::string& shape, const std::string& source, int iterations, unsigned lexThreads) {
+    size_t tokens = 0;
+    double lexTime = bestSeconds(iterations, [&] {
+        Lexer lexer{source};
+        tokens = lexer.getTokens().size();
+    });
+    report(shape, "lex", lexTime, static_cast<double>(tokens), "tokens", static_cast<double>(source.size()));
+
+    double parallelLexTime = bestSeconds(iterations, [&] {
+        tokens = lexParallel(source, lexThreads).size() - 1;
+    });
+    report(shape, "lex x" + std::to_string(lexThreads), parallelLexTime, static_cast<double>(tokens), "tokens",
+           static_cast<double>(source.size()));
+
+    size_t nodes = 0;
+    double parseTime = bestSeconds(iterations, [&] {
+        Lexer lexer{source};
+        AstArena arena;
+        Parser parser{lexer, arena};
+        auto statements = parser.parse();
+        Stats stats;
+        stats.countNodes(statements);
+        nodes = stats.totalNodes();
+    });
+    report(shape, "lex+parse", parseTime, static_cast<double>(nodes), "nodes", static_cast<double>(source.size()));
+
+    Lexer lexer{source};
+    AstArena arena;
+    Parser parser{lexer, arena};
+    auto statements = parser.parse();
+    Resolver resolver;
+    size_t slots = resolver.resolve(statements);
+
+    double interpretTime = bestSeconds(iterations, [&] {
+        Interpreter interpreter;
+        interpreter.interpret(statements, slots);
+    });
+    report(shape, "interpret", interpretTime, static_cast<double>(nodes), "ops", 0);
+
+    Chunk chunk;
+    double compileTime = bestSeconds(iterations, [&] {
+        Compiler compiler;
+        chunk = compiler.compile(statements, slots);
+    });
+    report(shape, "compile", compileTime, static_cast<double>(nodes), "nodes", 0);
+
+    double vmTime = bestSeconds(iterations, [&] {
+        VM vm;
+        vm.run(chunk);
+    });
+    report(shape, "vm", vmTime, static_cast<double>(nodes), "ops", 0);
+
+    std::unique_ptr<ClosureProgram> closures;
+    double closureCompileTime = bestSeconds(iterations, [&] {
+        closures = std::make_unique<ClosureProgram>();
+        ClosureCompiler compiler{*closures};
+        compiler.compile(statements, slots);
+    });
+    report(shape, "compile cl", closureCompileTime, static_cast<double>(nodes), "nodes", 0);
+
+    double closureTime = bestSeconds(iterations, [&] {
+        ClosureRunner runner;
+        runner.run(*closures);
+    });
+    report(shape, "closures", closureTime, static_cast<double>(nodes), "ops", 0);
+}
+
+int main(int argc, char** argv) {
+    std::string shape = "all";
+    size_t size = 8 * 1024 * 1024;
+    int iterations = 5;
+    unsigned lexThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--shape" && i + 1 < argc) {
+            shape = argv[++i];
+        } else if (arg == "--size" && i + 1 < argc) {
+            size = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::atoi(argv[++i]);
+        } else if (arg == "--lex-threads" && i + 1 < argc) {
+            lexThreads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--shape all|expr|block|literals|ifs|locals] [--size BYTES] [--iterations N]"
+                      << " [--lex-threads N]\n";
+            return -1;
+        }
+    }
+
+    struct Shape {
+        const char* name;
+        std::string (*generate)(size_t, std::mt19937&);
+    };
+    const Shape shapes[] = {
+        {"expr", deepExpressions},
+        {"block", longBlocks},
+        {"literals", manyLiterals},
+        {"ifs", nestedIfs},
+        {"locals", localArithmetic},
+    };
+
+    bool matched = false;
+    for (const Shape& s: shapes) {
+        if (shape != "all" && shape != s.name) {
+            continue;
+        }
+        matched = true;
+        std::mt19937 rng{12345};
+        std::string source = s.generate(size, rng);
+        try {
+            run(s.name, source, iterations, lexThreads);
+        } catch (std::exception& e) {
+            std::cerr << s.name << ": " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    if (!matched) {
+        std::cerr << "unknown shape: " << shape << std::endl;
+        return -1;
+    }
+    return 0;
+}
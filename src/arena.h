@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Contiguous, arena-owned array. Used for child lists inside AST nodes so a
+// node never owns a separately malloc'd buffer.
+template <typename T>
+class ArenaSpan {
+    public:
+        ArenaSpan() : items{nullptr}, count{0} {}
+        ArenaSpan(T* items, size_t count) : items{items}, count{count} {}
+
+        T* begin() const { return items; }
+        T* end() const { return items + count; }
+        size_t size() const { return count; }
+        T& operator[](size_t i) const { return items[i]; }
+
+    private:
+        T* items;
+        size_t count;
+};
+
+// Bump allocator for every Expr/Stmt of one compilation unit. Nodes are
+// placement-new'd into large blocks and released together when the arena is
+// destroyed; only types with non-trivial destructors are tracked.
+class AstArena {
+    public:
+        AstArena() = default;
+        AstArena(const AstArena&) = delete;
+        AstArena& operator=(const AstArena&) = delete;
+        AstArena(AstArena&&) = default;
+        AstArena& operator=(AstArena&&) = delete;
+
+        ~AstArena() {
+            for (auto it = destructors.rbegin(); it != destructors.rend(); ++it) {
+                it->second(it->first);
+            }
+        }
+
+        template <typename T, typename... Args>
+        T* make(Args&&... args) {
+            void* memory = allocate(sizeof(T), alignof(T));
+            T* object = new (memory) T(std::forward<Args>(args)...);
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                destructors.emplace_back(object, [](void* p) { static_cast<T*>(p)->~T(); });
+            }
+            return object;
+        }
+
+        template <typename T>
+        ArenaSpan<T> copy(const std::vector<T>& items) {
+            static_assert(std::is_trivially_copyable_v<T>, "arena arrays hold plain pointers/values");
+            if (items.empty()) {
+                return ArenaSpan<T>{};
+            }
+            T* memory = static_cast<T*>(allocate(sizeof(T) * items.size(), alignof(T)));
+            std::uninitialized_copy(items.begin(), items.end(), memory);
+            return ArenaSpan<T>{memory, items.size()};
+        }
+
+        void* allocate(size_t size, size_t align) {
+            uintptr_t aligned = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t)(align - 1);
+            if (cursor == nullptr || aligned + size > reinterpret_cast<uintptr_t>(limit)) {
+                size_t blockSize = size + align > BLOCK_SIZE ? size + align : BLOCK_SIZE;
+                blocks.emplace_back(new char[blockSize]);
+                cursor = blocks.back().get();
+                limit = cursor + blockSize;
+                aligned = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t)(align - 1);
+            }
+            cursor = reinterpret_cast<char*>(aligned + size);
+            return reinterpret_cast<void*>(aligned);
+        }
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+        std::vector<std::unique_ptr<char[]>> blocks;
+        std::vector<std::pair<void*, void (*)(void*)>> destructors;
+        char* cursor = nullptr;
+        char* limit = nullptr;
+};
@@ -0,0 +1,119 @@
+#include "batch.h"
+#include "output.h"
+#include "simplelang.h"
+#include "source.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+std::vector<std::string> batchScripts(const std::string& target) {
+    std::vector<std::string> paths;
+    std::error_code error;
+
+    if (fs::is_directory(target, error)) {
+        for (const auto& entry: fs::recursive_directory_iterator(target, error)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".sl") {
+                paths.push_back(entry.path().string());
+            }
+        }
+        if (error) {
+            throw std::runtime_error("Could not read directory: " + target);
+        }
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    std::ifstream manifest(target);
+    if (!manifest) {
+        throw std::runtime_error("Could not open file: " + target);
+    }
+    fs::path base = fs::path(target).parent_path();
+    std::string line;
+    while (std::getline(manifest, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        fs::path path{line};
+        paths.push_back(path.is_relative() ? (base / path).string() : line);
+    }
+    return paths;
+}
+
+namespace {
+
+struct BatchResult {
+    StringSink output;
+    std::string error;
+    bool done = false;
+};
+
+}
+
+size_t runBatch(const std::vector<std::string>& paths, const BatchOptions& options) {
+    simplelang::Engine engine{options.backend};
+
+    std::vector<BatchResult> results(paths.size());
+    std::atomic<size_t> next{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    auto worker = [&] {
+        for (size_t i = next++; i < paths.size(); i = next++) {
+            BatchResult& result = results[i];
+            SourceFile source;
+            if (!source.open(paths[i])) {
+                result.error = "Could not open file";
+            } else {
+                try {
+                    engine.eval(source.text(), {}, {}, &result.output);
+                } catch (std::exception& e) {
+                    result.error = e.what();
+                }
+            }
+            std::lock_guard<std::mutex> lock{mutex};
+            result.done = true;
+            finished.notify_one();
+        }
+    };
+
+    unsigned jobs = options.jobs != 0 ? options.jobs : std::max(1u, std::thread::hardware_concurrency());
+    jobs = static_cast<unsigned>(std::min<size_t>(jobs, std::max<size_t>(paths.size(), 1)));
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < jobs; i++) {
+        workers.emplace_back(worker);
+    }
+
+    // Results are written as soon as every earlier script has finished, so a
+    // slow script holds back the ones after it but never reorders them.
+    size_t failures = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            finished.wait(lock, [&] { return results[i].done; });
+        }
+        standardOutput().write(results[i].output.str());
+        if (!results[i].error.empty()) {
+            standardOutput().flush();
+            std::cerr << paths[i] << ": " << results[i].error << std::endl;
+            failures++;
+        }
+        results[i].output = StringSink{};
+    }
+    standardOutput().flush();
+
+    for (std::thread& thread: workers) {
+        thread.join();
+    }
+    return failures;
+}
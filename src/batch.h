@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "simplelang.h"
+
+struct BatchOptions {
+    simplelang::Backend backend = simplelang::Backend::Tree;
+    // Worker threads; 0 uses one per hardware thread.
+    unsigned jobs = 0;
+};
+
+// Scripts named by `target`: every *.sl file under a directory, in path
+// order, or the lines of a manifest file. Blank lines and lines starting with
+// '#' are skipped; relative paths are taken relative to the manifest.
+// Throws std::runtime_error if `target` cannot be read.
+std::vector<std::string> batchScripts(const std::string& target);
+
+// Runs every script on a pool of workers sharing one compiled-script cache.
+// Each script's output is buffered and written to stdout in the order the
+// scripts were given, errors to stderr prefixed with the script path.
+// Returns the number of scripts that failed.
+size_t runBatch(const std::vector<std::string>& paths, const BatchOptions& options);
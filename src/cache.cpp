@@ -0,0 +1,79 @@
+#include "cache.h"
+#include "program.h"
+
+namespace simplelang {
+
+static uint64_t fnv1a(uint64_t hash, std::string_view bytes) {
+    for (unsigned char byte: bytes) {
+        hash ^= byte;
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+uint64_t scriptKey(std::string_view source, const std::vector<std::string>& inputs) {
+    uint64_t hash = fnv1a(0xcbf29ce484222325, source);
+    for (const std::string& name: inputs) {
+        // Separator keeps {"ab"} and {"a", "b"} apart.
+        hash = fnv1a(hash, std::string_view("\0", 1));
+        hash = fnv1a(hash, name);
+    }
+    return hash;
+}
+
+Script ScriptCache::find(uint64_t key, std::string_view source, const std::vector<std::string>& inputs) {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto it = index.find(key);
+    if (it == index.end() || it->second->script.program->source != source || it->second->script.inputs() != inputs) {
+        missCount++;
+        return Script{};
+    }
+    hitCount++;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->script;
+}
+
+void ScriptCache::insert(uint64_t key, const Script& script) {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (capacity == 0) {
+        return;
+    }
+    auto it = index.find(key);
+    if (it != index.end()) {
+        entries.erase(it->second);
+        index.erase(it);
+    }
+    entries.push_front(Entry{key, script});
+    index[key] = entries.begin();
+    evict();
+}
+
+void ScriptCache::setCapacity(size_t entryLimit) {
+    std::lock_guard<std::mutex> lock{mutex};
+    capacity = entryLimit;
+    evict();
+}
+
+size_t ScriptCache::size() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return entries.size();
+}
+
+uint64_t ScriptCache::hits() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return hitCount;
+}
+
+uint64_t ScriptCache::misses() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return missCount;
+}
+
+void ScriptCache::evict() {
+    while (entries.size() > capacity) {
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
+
+}
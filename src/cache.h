@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "simplelang.h"
+
+namespace simplelang {
+
+// FNV-1a over the source text and input names.
+uint64_t scriptKey(std::string_view source, const std::vector<std::string>& inputs);
+
+// Least-recently-used cache of compiled scripts, keyed by scriptKey. A hit
+// is confirmed against the stored source and inputs, so a hash collision
+// can only cause a miss, never the wrong program. Safe to share between
+// threads; cached Scripts are immutable.
+class ScriptCache {
+    public:
+        ScriptCache(size_t capacity) : capacity{capacity} {}
+
+        // Returns an invalid Script on a miss.
+        Script find(uint64_t key, std::string_view source, const std::vector<std::string>& inputs);
+        void insert(uint64_t key, const Script& script);
+
+        void setCapacity(size_t entries);
+        size_t size() const;
+        uint64_t hits() const;
+        uint64_t misses() const;
+
+    private:
+        struct Entry {
+            uint64_t key;
+            Script script;
+        };
+
+        void evict();
+
+        mutable std::mutex mutex;
+        size_t capacity;
+        std::list<Entry> entries;
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+        uint64_t hitCount = 0;
+        uint64_t missCount = 0;
+};
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "value.h"
+
+// X-macro so the VM's computed-goto table always matches the enum order.
+#define SL_OPCODES(X) \
+    X(Constant)       \
+    X(Nil)            \
+    X(True)           \
+    X(False)          \
+    X(Pop)            \
+    X(GetLocal)       \
+    X(SetLocal)       \
+    X(Negate)         \
+    X(Add)            \
+    X(Subtract)       \
+    X(Multiply)       \
+    X(Divide)         \
+    X(Equal)          \
+    X(NotEqual)       \
+    X(Less)           \
+    X(LessEqual)      \
+    X(Greater)        \
+    X(GreaterEqual)   \
+    X(Print)          \
+    X(Call)           \
+    X(Jump)           \
+    X(JumpIfFalse)    \
+    X(Return)         \
+    SL_BINARY_OPCODES(X, LocalLocal)           \
+    SL_BINARY_OPCODES(X, LocalConstant)        \
+    SL_BINARY_OPCODES(X, ConstantLocal)        \
+    SL_COMPARE_OPCODES(X, JumpIfFalse)         \
+    SL_COMPARE_OPCODES(X, LocalLocalJumpIfFalse)    \
+    SL_COMPARE_OPCODES(X, LocalConstantJumpIfFalse) \
+    SL_COMPARE_OPCODES(X, ConstantLocalJumpIfFalse)
+
+// Superinstructions, one opcode per operator and operand shape, so the VM
+// does a single dispatch where it would otherwise do three or four.
+//
+//   <op>LocalLocal a b          push slots[a] <op> slots[b]
+//   <op>LocalConstant a k       push slots[a] <op> constants[k]
+//   <op>ConstantLocal k b       push constants[k] <op> slots[b]
+//   <cmp>JumpIfFalse t          pop two operands, jump to t unless they compare
+//   <cmp><shape>JumpIfFalse x y t   the same with operands taken as above
+//
+// The compiler picks them; nothing else needs to know they exist.
+#define SL_COMPARE_OPCODES(X, shape) \
+    X(Equal##shape)                  \
+    X(NotEqual##shape)               \
+    X(Less##shape)                   \
+    X(LessEqual##shape)              \
+    X(Greater##shape)                \
+    X(GreaterEqual##shape)
+
+#define SL_BINARY_OPCODES(X, shape) \
+    X(Add##shape)                   \
+    X(Subtract##shape)              \
+    X(Multiply##shape)              \
+    X(Divide##shape)                \
+    SL_COMPARE_OPCODES(X, shape)
+
+enum class OpCode : uint8_t {
+#define SL_OPCODE_ENUM(name) name,
+    SL_OPCODES(SL_OPCODE_ENUM)
+#undef SL_OPCODE_ENUM
+};
+
+// Flat bytecode for one compilation unit. Operands are little-endian u32s
+// stored inline after the opcode byte.
+struct Chunk {
+    std::vector<uint8_t> code;
+    std::vector<Value> constants;
+    size_t maxStack = 0;
+    // Variable frame size, as reported by the Resolver.
+    size_t slots = 0;
+
+    void write(OpCode op) { code.push_back(static_cast<uint8_t>(op)); }
+
+    void writeU32(uint32_t operand) {
+        uint8_t bytes[4];
+        std::memcpy(bytes, &operand, sizeof(operand));
+        code.insert(code.end(), bytes, bytes + 4);
+    }
+
+    void patchU32(size_t offset, uint32_t operand) {
+        std::memcpy(&code[offset], &operand, sizeof(operand));
+    }
+
+    uint32_t addConstant(Value value) {
+        constants.push_back(value);
+        return static_cast<uint32_t>(constants.size() - 1);
+    }
+};
+
+inline uint32_t readU32(const uint8_t* ip) {
+    uint32_t operand;
+    std::memcpy(&operand, ip, sizeof(operand));
+    return operand;
+}
@@ -0,0 +1,332 @@
+#include "closure.h"
+#include "operators.h"
+#include "string_object.h"
+#include <stdexcept>
+
+#if defined(__GNUC__)
+#define SL_ALWAYS_INLINE __attribute__((always_inline)) inline
+#else
+#define SL_ALWAYS_INLINE inline
+#endif
+
+// The functions closures point at. Each is instantiated once per operator
+// and operand kinds it is used with, so the operator's switch in binaryOp()
+// and the operand fetches fold away.
+struct ClosureOps {
+    template <ClosureOperand kind>
+    static SL_ALWAYS_INLINE Value operand(const ExprClosure* node, ClosureRunner& runner) {
+        if constexpr (kind == ClosureOperand::Local) {
+            return runner.frame[static_cast<const VariableClosure*>(node)->slot];
+        } else if constexpr (kind == ClosureOperand::Constant) {
+            return static_cast<const LiteralClosure*>(node)->constant;
+        } else {
+            return node->run(node, runner);
+        }
+    }
+
+    template <TokenType op, ClosureOperand left, ClosureOperand right>
+    struct Binary {
+        static Value run(const ExprClosure* self, ClosureRunner& runner) {
+            auto node = static_cast<const BinaryClosure*>(self);
+            Value lhs = operand<left>(node->left, runner);
+            Value rhs = operand<right>(node->right, runner);
+            return binaryOp(op, lhs, rhs);
+        }
+    };
+
+    // An if on a binary condition, evaluated inline.
+    template <TokenType op, ClosureOperand left, ClosureOperand right>
+    struct IfBinary {
+        static void run(const StmtClosure* self, ClosureRunner& runner) {
+            auto node = static_cast<const IfClosure*>(self);
+            auto condition = static_cast<const BinaryClosure*>(node->condition);
+            Value lhs = operand<left>(condition->left, runner);
+            Value rhs = operand<right>(condition->right, runner);
+            branch(node, runner, binaryOp(op, lhs, rhs).isTruthy());
+        }
+    };
+
+    static Value literal(const ExprClosure* self, ClosureRunner&) {
+        return static_cast<const LiteralClosure*>(self)->constant;
+    }
+
+    static Value variable(const ExprClosure* self, ClosureRunner& runner) {
+        return runner.frame[static_cast<const VariableClosure*>(self)->slot];
+    }
+
+    static Value negate(const ExprClosure* self, ClosureRunner& runner) {
+        const ExprClosure* operand = static_cast<const UnaryClosure*>(self)->operand;
+        return Value::number(-numberOperand(operand->run(operand, runner)));
+    }
+
+    static Value assign(const ExprClosure* self, ClosureRunner& runner) {
+        auto node = static_cast<const UnaryClosure*>(self);
+        Value value = node->operand->run(node->operand, runner);
+        storeValue(runner.frame[node->slot], value);
+        return value;
+    }
+
+    static Value call(const ExprClosure* self, ClosureRunner& runner) {
+        auto node = static_cast<const CallClosure*>(self);
+        std::vector<Value> arguments;
+        arguments.reserve(node->arguments.size());
+        for (const ExprClosure* argument: node->arguments) {
+            arguments.push_back(argument->run(argument, runner));
+        }
+        return (*runner.natives)[node->native].function(arguments.data(), arguments.size());
+    }
+
+    // No expression is half evaluated between statements, so that is where
+    // runtime strings nothing refers to any more are freed.
+    static SL_ALWAYS_INLINE void execute(const StmtClosure* stmt, ClosureRunner& runner) {
+        if (StringObject::collectionDue()) {
+            StringObject::collect();
+        }
+        stmt->run(stmt, runner);
+    }
+
+    static SL_ALWAYS_INLINE void branch(const IfClosure* node, ClosureRunner& runner, bool taken) {
+        if (taken) {
+            execute(node->then, runner);
+        } else if (node->otherwise != nullptr) {
+            execute(node->otherwise, runner);
+        }
+    }
+
+    static void expressionStmt(const StmtClosure* self, ClosureRunner& runner) {
+        const ExprClosure* expression = static_cast<const ExpressionStmtClosure*>(self)->expression;
+        expression->run(expression, runner);
+    }
+
+    static void print(const StmtClosure* self, ClosureRunner& runner) {
+        const ExprClosure* expression = static_cast<const ExpressionStmtClosure*>(self)->expression;
+        printValue(*runner.out, expression->run(expression, runner));
+    }
+
+    static void var(const StmtClosure* self, ClosureRunner& runner) {
+        auto node = static_cast<const ExpressionStmtClosure*>(self);
+        Value value = Value::nil();
+        if (node->expression != nullptr) {
+            value = node->expression->run(node->expression, runner);
+        }
+        storeValue(runner.frame[node->slot], value);
+    }
+
+    static void ifStmt(const StmtClosure* self, ClosureRunner& runner) {
+        auto node = static_cast<const IfClosure*>(self);
+        branch(node, runner, node->condition->run(node->condition, runner).isTruthy());
+    }
+
+    static void block(const StmtClosure* self, ClosureRunner& runner) {
+        for (const StmtClosure* stmt: static_cast<const BlockClosure*>(self)->body) {
+            execute(stmt, runner);
+        }
+    }
+
+    // Picks Node<op, left, right>::run for operands known only at compile
+    // time, one runtime parameter at a time.
+    template <template <TokenType, ClosureOperand, ClosureOperand> class Node, TokenType op, ClosureOperand left>
+    static auto select(ClosureOperand right) {
+        switch (right) {
+            case ClosureOperand::Local: return &Node<op, left, ClosureOperand::Local>::run;
+            case ClosureOperand::Constant: return &Node<op, left, ClosureOperand::Constant>::run;
+            default: return &Node<op, left, ClosureOperand::Node>::run;
+        }
+    }
+
+    template <template <TokenType, ClosureOperand, ClosureOperand> class Node, TokenType op>
+    static auto select(ClosureOperand left, ClosureOperand right) {
+        switch (left) {
+            case ClosureOperand::Local: return select<Node, op, ClosureOperand::Local>(right);
+            case ClosureOperand::Constant: return select<Node, op, ClosureOperand::Constant>(right);
+            default: return select<Node, op, ClosureOperand::Node>(right);
+        }
+    }
+
+    // Null for an operator binaryOp() does not implement.
+    template <template <TokenType, ClosureOperand, ClosureOperand> class Node>
+    static auto select(TokenType op, ClosureOperand left, ClosureOperand right)
+        -> decltype(select<Node, TokenType::Plus>(left, right)) {
+        switch (op) {
+            case TokenType::Plus: return select<Node, TokenType::Plus>(left, right);
+            case TokenType::Minus: return select<Node, TokenType::Minus>(left, right);
+            case TokenType::Star: return select<Node, TokenType::Star>(left, right);
+            case TokenType::Slash: return select<Node, TokenType::Slash>(left, right);
+            case TokenType::EqualEqual: return select<Node, TokenType::EqualEqual>(left, right);
+            case TokenType::BangEqual: return select<Node, TokenType::BangEqual>(left, right);
+            case TokenType::Less: return select<Node, TokenType::Less>(left, right);
+            case TokenType::LessEqual: return select<Node, TokenType::LessEqual>(left, right);
+            case TokenType::Greater: return select<Node, TokenType::Greater>(left, right);
+            case TokenType::GreaterEqual: return select<Node, TokenType::GreaterEqual>(left, right);
+            default: return nullptr;
+        }
+    }
+};
+
+static ClosureOperand operandKind(const ExprClosure* node) {
+    if (node->run == ClosureOps::variable) return ClosureOperand::Local;
+    if (node->run == ClosureOps::literal) return ClosureOperand::Constant;
+    return ClosureOperand::Node;
+}
+
+void ClosureCompiler::compile(std::vector<Stmt*>& statements, size_t slots) {
+    program.slots = slots;
+    program.statements.clear();
+    program.statements.reserve(statements.size());
+    for (Stmt* stmt: statements) {
+        program.statements.push_back(compile(stmt));
+    }
+}
+
+const ExprClosure* ClosureCompiler::compile(Expr* expr) {
+    expr->accept(this);
+    return compiledExpr;
+}
+
+const StmtClosure* ClosureCompiler::compile(Stmt* stmt) {
+    stmt->accept(this);
+    return compiledStmt;
+}
+
+// Written straight into the arena rather than through arena.copy(), which
+// would cost a temporary vector per block.
+template <typename T, typename Nodes>
+ArenaSpan<T> ClosureCompiler::compileAll(Nodes& nodes) {
+    if (nodes.size() == 0) {
+        return ArenaSpan<T>{};
+    }
+    T* items = static_cast<T*>(program.arena.allocate(sizeof(T) * nodes.size(), alignof(T)));
+    size_t count = 0;
+    for (auto node: nodes) {
+        items[count++] = compile(node);
+    }
+    return ArenaSpan<T>{items, count};
+}
+
+Value ClosureCompiler::visitLiteralExpr(LiteralExpr* expr) {
+    auto node = program.arena.make<LiteralClosure>();
+    node->run = ClosureOps::literal;
+    node->constant = expr->getValue();
+    compiledExpr = node;
+    return Value::nil();
+}
+
+Value ClosureCompiler::visitUnaryExpr(UnaryExpr* expr) {
+    const ExprClosure* right = compile(expr->getRight());
+    // Unary plus is the identity, as in unaryOp(), so it needs no node.
+    if (expr->getOp().type != TokenType::Minus) {
+        return Value::nil();
+    }
+    auto node = program.arena.make<UnaryClosure>();
+    node->run = ClosureOps::negate;
+    node->operand = right;
+    compiledExpr = node;
+    return Value::nil();
+}
+
+Value ClosureCompiler::visitBinaryExpr(BinaryExpr* expr) {
+    auto node = program.arena.make<BinaryClosure>();
+    node->left = compile(expr->getLeft());
+    node->right = compile(expr->getRight());
+    node->run = ClosureOps::select<ClosureOps::Binary>(expr->getOp().type, operandKind(node->left),
+                                                       operandKind(node->right));
+    if (node->run == nullptr) {
+        throw std::runtime_error("Unsupported binary operator: " + std::string(expr->getOp().lexeme));
+    }
+    compiledExpr = node;
+    return Value::nil();
+}
+
+Value ClosureCompiler::visitVariableExpr(VariableExpr* expr) {
+    auto node = program.arena.make<VariableClosure>();
+    node->run = ClosureOps::variable;
+    node->slot = expr->getSlot();
+    compiledExpr = node;
+    return Value::nil();
+}
+
+Value ClosureCompiler::visitAssignExpr(AssignExpr* expr) {
+    auto node = program.arena.make<UnaryClosure>();
+    node->run = ClosureOps::assign;
+    node->operand = compile(expr->getValue());
+    node->slot = expr->getSlot();
+    compiledExpr = node;
+    return Value::nil();
+}
+
+Value ClosureCompiler::visitCallExpr(CallExpr* expr) {
+    auto node = program.arena.make<CallClosure>();
+    node->run = ClosureOps::call;
+    node->native = expr->getNative();
+    node->arguments = compileAll<const ExprClosure*>(expr->getArguments());
+    compiledExpr = node;
+    return Value::nil();
+}
+
+void ClosureCompiler::visitExpressionStmt(ExpressionStmt* stmt) {
+    auto node = program.arena.make<ExpressionStmtClosure>();
+    node->run = ClosureOps::expressionStmt;
+    node->expression = compile(stmt->getExpression());
+    compiledStmt = node;
+}
+
+void ClosureCompiler::visitPrintStmt(PrintStmt* stmt) {
+    auto node = program.arena.make<ExpressionStmtClosure>();
+    node->run = ClosureOps::print;
+    node->expression = compile(stmt->getExpression());
+    compiledStmt = node;
+}
+
+void ClosureCompiler::visitVarStmt(VarStmt* stmt) {
+    auto node = program.arena.make<ExpressionStmtClosure>();
+    node->run = ClosureOps::var;
+    node->expression = stmt->getInitializer() != nullptr ? compile(stmt->getInitializer()) : nullptr;
+    node->slot = stmt->getSlot();
+    compiledStmt = node;
+}
+
+// A binary condition is evaluated by the if node itself, which reads the
+// operands out of the condition's node but never calls it.
+void ClosureCompiler::visitIfStmt(IfStmt* stmt) {
+    auto node = program.arena.make<IfClosure>();
+    node->condition = compile(stmt->getCondition());
+    node->run = ClosureOps::ifStmt;
+    if (auto condition = dynamic_cast<BinaryExpr*>(stmt->getCondition())) {
+        auto compiled = static_cast<const BinaryClosure*>(node->condition);
+        node->run = ClosureOps::select<ClosureOps::IfBinary>(condition->getOp().type, operandKind(compiled->left),
+                                                             operandKind(compiled->right));
+    }
+    node->then = compile(stmt->getThen());
+    node->otherwise = stmt->hasOtherStmt() ? compile(stmt->getOtherwise()) : nullptr;
+    compiledStmt = node;
+}
+
+void ClosureCompiler::visitBlockStmt(BlockStmt* stmt) {
+    auto node = program.arena.make<BlockClosure>();
+    node->run = ClosureOps::block;
+    node->body = compileAll<const StmtClosure*>(stmt->getStatements());
+    compiledStmt = node;
+}
+
+ClosureRunner::~ClosureRunner() {
+    for (const Value& value: frame) {
+        StringObject::release(value);
+    }
+    StringObject::collect();
+}
+
+void ClosureRunner::bind(uint32_t slot, Value value) {
+    if (frame.size() <= slot) {
+        frame.resize(slot + 1);
+    }
+    storeValue(frame[slot], value);
+}
+
+void ClosureRunner::run(const ClosureProgram& program) {
+    if (frame.size() < program.slots) {
+        frame.resize(program.slots);
+    }
+    for (const StmtClosure* stmt: program.statements) {
+        ClosureOps::execute(stmt, *this);
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "arena.h"
+#include "expr.h"
+#include "natives.h"
+#include "output.h"
+#include "value.h"
+
+class ClosureRunner;
+
+// Closure-compiled form of the AST. Every Expr and Stmt becomes a node with
+// a plain function pointer, chosen once at compile time from templates
+// specialized on the operator and on where each operand comes from. Running
+// a node is a single indirect call: no visitor double dispatch and no switch
+// on the operator. A binary operator whose operand is a variable or a
+// literal reads it straight out of the child node instead of calling it, and
+// an if whose condition is a binary operator evaluates it inline.
+//
+// Nodes are plain data, so one compiled program can be run by any number of
+// ClosureRunners at once.
+struct ExprClosure {
+    Value (*run)(const ExprClosure* self, ClosureRunner& runner);
+};
+
+struct StmtClosure {
+    void (*run)(const StmtClosure* self, ClosureRunner& runner);
+};
+
+// Each node kind only holds what its functions read, so a compiled program
+// stays about as compact as its AST.
+struct LiteralClosure: ExprClosure {
+    Value constant;
+};
+
+struct VariableClosure: ExprClosure {
+    uint32_t slot;
+};
+
+// Unary operators and assignments.
+struct UnaryClosure: ExprClosure {
+    const ExprClosure* operand;
+    uint32_t slot;
+};
+
+struct BinaryClosure: ExprClosure {
+    const ExprClosure* left;
+    const ExprClosure* right;
+};
+
+struct CallClosure: ExprClosure {
+    ArenaSpan<const ExprClosure*> arguments;
+    uint32_t native;
+};
+
+// Expression, print and var statements. `slot` is only used by var, whose
+// `expression` is null when it has no initializer.
+struct ExpressionStmtClosure: StmtClosure {
+    const ExprClosure* expression;
+    uint32_t slot;
+};
+
+struct IfClosure: StmtClosure {
+    const ExprClosure* condition;
+    const StmtClosure* then;
+    // Null when there is no else branch.
+    const StmtClosure* otherwise;
+};
+
+struct BlockClosure: StmtClosure {
+    ArenaSpan<const StmtClosure*> body;
+};
+
+// Where a specialized node reads an operand from: by calling the child node,
+// or, when the child is a variable or a literal, from its slot or constant.
+enum class ClosureOperand { Node, Local, Constant };
+
+struct ClosureProgram {
+    AstArena arena;
+    std::vector<const StmtClosure*> statements;
+    // Variable frame size, as reported by the Resolver.
+    size_t slots = 0;
+};
+
+// Walks a resolved and folded AST once and fills `program` with its
+// closures. The AST is not referenced afterwards.
+class ClosureCompiler: public ExprVisitor, public StmtVisitor {
+    public:
+        explicit ClosureCompiler(ClosureProgram& program) : program{program} {}
+
+        void compile(std::vector<Stmt*>& statements, size_t slots);
+
+    private:
+        const ExprClosure* compile(Expr* expr);
+        const StmtClosure* compile(Stmt* stmt);
+        template <typename T, typename Nodes>
+        ArenaSpan<T> compileAll(Nodes& nodes);
+
+        Value visitLiteralExpr(LiteralExpr* expr) override;
+        Value visitUnaryExpr(UnaryExpr* expr) override;
+        Value visitBinaryExpr(BinaryExpr* expr) override;
+        Value visitVariableExpr(VariableExpr* expr) override;
+        Value visitAssignExpr(AssignExpr* expr) override;
+        Value visitCallExpr(CallExpr* expr) override;
+
+        void visitExpressionStmt(ExpressionStmt* stmt) override;
+        void visitPrintStmt(PrintStmt* stmt) override;
+        void visitVarStmt(VarStmt* stmt) override;
+        void visitIfStmt(IfStmt* stmt) override;
+        void visitBlockStmt(BlockStmt* stmt) override;
+
+    private:
+        ClosureProgram& program;
+        // What the last visit compiled.
+        const ExprClosure* compiledExpr = nullptr;
+        const StmtClosure* compiledStmt = nullptr;
+};
+
+// Runs closure-compiled programs. Like the Interpreter and the VM it keeps
+// its variable frame between runs.
+class ClosureRunner {
+    public:
+        ClosureRunner(const Natives* natives = nullptr, OutputSink* out = nullptr)
+        : natives{natives}, out{out != nullptr ? out : &standardOutput()} {}
+        ClosureRunner(const ClosureRunner&) = delete;
+        ClosureRunner& operator=(const ClosureRunner&) = delete;
+        ~ClosureRunner();
+
+        void run(const ClosureProgram& program);
+
+        // Presets a variable slot, e.g. a host-supplied input.
+        void bind(uint32_t slot, Value value);
+
+    private:
+        friend struct ClosureOps;
+
+        const Natives* natives;
+        OutputSink* out;
+        std::vector<Value> frame;
+};
@@ -0,0 +1,212 @@
+#include "compiler.h"
+#include <stdexcept>
+
+// Position of a binary operator within each SL_BINARY_OPCODES group, which
+// all list the operators in the same order as the plain opcodes Add through
+// GreaterEqual. Comparisons come last, so `index - COMPARE_BASE` is the
+// position within an SL_COMPARE_OPCODES group. -1 if there is no opcode.
+static constexpr int COMPARE_BASE = 4;
+
+static int binaryIndex(TokenType type) {
+    switch (type) {
+        case TokenType::Plus: return 0;
+        case TokenType::Minus: return 1;
+        case TokenType::Star: return 2;
+        case TokenType::Slash: return 3;
+        case TokenType::EqualEqual: return 4;
+        case TokenType::BangEqual: return 5;
+        case TokenType::Less: return 6;
+        case TokenType::LessEqual: return 7;
+        case TokenType::Greater: return 8;
+        case TokenType::GreaterEqual: return 9;
+        default: return -1;
+    }
+}
+
+static OpCode shaped(OpCode first, int index) {
+    return static_cast<OpCode>(static_cast<uint8_t>(first) + index);
+}
+
+enum class OperandKind { Stack, Local, Constant };
+
+// Where a superinstruction can fetch `expr` from without evaluating it.
+static OperandKind operandKind(Expr* expr) {
+    if (dynamic_cast<VariableExpr*>(expr) != nullptr) return OperandKind::Local;
+    if (dynamic_cast<LiteralExpr*>(expr) != nullptr) return OperandKind::Constant;
+    return OperandKind::Stack;
+}
+
+Chunk Compiler::compile(std::vector<Stmt*>& statements, size_t slots) {
+    chunk = Chunk{};
+    chunk.slots = slots;
+    depth = 0;
+    for (auto& stmt: statements) {
+        stmt->accept(this);
+    }
+    emit(OpCode::Return, 0);
+    return std::move(chunk);
+}
+
+void Compiler::emit(OpCode op, int stackEffect) {
+    chunk.write(op);
+    depth += stackEffect;
+    if (depth > chunk.maxStack) {
+        chunk.maxStack = depth;
+    }
+}
+
+size_t Compiler::emitJump(OpCode op, int stackEffect) {
+    emit(op, stackEffect);
+    chunk.writeU32(0);
+    return chunk.code.size() - 4;
+}
+
+// A comparison used as a condition jumps on its own result instead of
+// pushing a boolean for JumpIfFalse to pop.
+size_t Compiler::emitConditionJump(Expr* condition) {
+    auto comparison = dynamic_cast<BinaryExpr*>(condition);
+    int index = comparison != nullptr ? binaryIndex(comparison->getOp().type) - COMPARE_BASE : -1;
+    if (index < 0) {
+        condition->accept(this);
+        return emitJump(OpCode::JumpIfFalse, -1);
+    }
+    if (!emitFused(comparison, shaped(OpCode::EqualLocalLocalJumpIfFalse, index),
+                   shaped(OpCode::EqualLocalConstantJumpIfFalse, index),
+                   shaped(OpCode::EqualConstantLocalJumpIfFalse, index), 0)) {
+        comparison->getLeft()->accept(this);
+        comparison->getRight()->accept(this);
+        emit(shaped(OpCode::EqualJumpIfFalse, index), -2);
+    }
+    chunk.writeU32(0);
+    return chunk.code.size() - 4;
+}
+
+void Compiler::patchJump(size_t operand) {
+    chunk.patchU32(operand, static_cast<uint32_t>(chunk.code.size()));
+}
+
+Value Compiler::visitLiteralExpr(LiteralExpr* expr) {
+    Value value = expr->getValue();
+    if (value.isNil()) {
+        emit(OpCode::Nil, 1);
+    } else if (value.isBool()) {
+        emit(value.asBool() ? OpCode::True : OpCode::False, 1);
+    } else {
+        emit(OpCode::Constant, 1);
+        chunk.writeU32(chunk.addConstant(value));
+    }
+    return Value::nil();
+}
+
+Value Compiler::visitUnaryExpr(UnaryExpr* expr) {
+    expr->getRight()->accept(this);
+    switch (expr->getOp().type) {
+        case TokenType::Minus: emit(OpCode::Negate, 0); break;
+        default: break;
+    }
+    return Value::nil();
+}
+
+void Compiler::writeOperand(Expr* expr) {
+    if (auto variable = dynamic_cast<VariableExpr*>(expr)) {
+        chunk.writeU32(variable->getSlot());
+    } else {
+        chunk.writeU32(chunk.addConstant(static_cast<LiteralExpr*>(expr)->getValue()));
+    }
+}
+
+bool Compiler::emitFused(BinaryExpr* expr, OpCode localLocal, OpCode localConstant, OpCode constantLocal, int stackEffect) {
+    OperandKind left = operandKind(expr->getLeft());
+    OperandKind right = operandKind(expr->getRight());
+    if (left == OperandKind::Local && right == OperandKind::Local) {
+        emit(localLocal, stackEffect);
+    } else if (left == OperandKind::Local && right == OperandKind::Constant) {
+        emit(localConstant, stackEffect);
+    } else if (left == OperandKind::Constant && right == OperandKind::Local) {
+        emit(constantLocal, stackEffect);
+    } else {
+        return false;
+    }
+    writeOperand(expr->getLeft());
+    writeOperand(expr->getRight());
+    return true;
+}
+
+Value Compiler::visitBinaryExpr(BinaryExpr* expr) {
+    int index = binaryIndex(expr->getOp().type);
+    if (index < 0) {
+        throw std::runtime_error("Unsupported binary operator: " + std::string(expr->getOp().lexeme));
+    }
+    if (emitFused(expr, shaped(OpCode::AddLocalLocal, index), shaped(OpCode::AddLocalConstant, index),
+                  shaped(OpCode::AddConstantLocal, index), 1)) {
+        return Value::nil();
+    }
+    expr->getLeft()->accept(this);
+    expr->getRight()->accept(this);
+    emit(shaped(OpCode::Add, index), -1);
+    return Value::nil();
+}
+
+Value Compiler::visitVariableExpr(VariableExpr* expr) {
+    emit(OpCode::GetLocal, 1);
+    chunk.writeU32(expr->getSlot());
+    return Value::nil();
+}
+
+Value Compiler::visitAssignExpr(AssignExpr* expr) {
+    expr->getValue()->accept(this);
+    emit(OpCode::SetLocal, 0);
+    chunk.writeU32(expr->getSlot());
+    return Value::nil();
+}
+
+Value Compiler::visitCallExpr(CallExpr* expr) {
+    for (Expr* argument: expr->getArguments()) {
+        argument->accept(this);
+    }
+    int argc = static_cast<int>(expr->getArguments().size());
+    emit(OpCode::Call, 1 - argc);
+    chunk.writeU32(expr->getNative());
+    chunk.writeU32(static_cast<uint32_t>(argc));
+    return Value::nil();
+}
+
+void Compiler::visitExpressionStmt(ExpressionStmt* stmt) {
+    stmt->getExpression()->accept(this);
+    emit(OpCode::Pop, -1);
+}
+
+void Compiler::visitPrintStmt(PrintStmt* stmt) {
+    stmt->getExpression()->accept(this);
+    emit(OpCode::Print, -1);
+}
+
+void Compiler::visitVarStmt(VarStmt* stmt) {
+    if (stmt->getInitializer() != nullptr) {
+        stmt->getInitializer()->accept(this);
+    } else {
+        emit(OpCode::Nil, 1);
+    }
+    emit(OpCode::SetLocal, 0);
+    chunk.writeU32(stmt->getSlot());
+    emit(OpCode::Pop, -1);
+}
+
+void Compiler::visitIfStmt(IfStmt* stmt) {
+    size_t elseJump = emitConditionJump(stmt->getCondition());
+    stmt->getThen()->accept(this);
+    if (stmt->hasOtherStmt()) {
+        size_t endJump = emitJump(OpCode::Jump, 0);
+        patchJump(elseJump);
+        stmt->getOtherwise()->accept(this);
+        patchJump(endJump);
+    } else {
+        patchJump(elseJump);
+    }
+}
+
+void Compiler::visitBlockStmt(BlockStmt* stmt) {
+    for (auto& s: stmt->getStatements()) {
+        s->accept(this);
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include "chunk.h"
+#include "expr.h"
+
+// Lowers the parser's AST into a flat Chunk for the VM.
+class Compiler: public ExprVisitor, public StmtVisitor {
+    public:
+        Chunk compile(std::vector<Stmt*>& statements, size_t slots);
+
+    private:
+        void emit(OpCode op, int stackEffect);
+        size_t emitJump(OpCode op, int stackEffect);
+        void patchJump(size_t operand);
+        size_t emitConditionJump(Expr* condition);
+
+        // Emits `expr` as one superinstruction when each operand is a local
+        // or a literal and not both are literals. Returns false, having
+        // emitted nothing, otherwise.
+        bool emitFused(BinaryExpr* expr, OpCode localLocal, OpCode localConstant, OpCode constantLocal, int stackEffect);
+        void writeOperand(Expr* expr);
+
+        Value visitLiteralExpr(LiteralExpr* expr) override;
+        Value visitUnaryExpr(UnaryExpr* expr) override;
+        Value visitBinaryExpr(BinaryExpr* expr) override;
+        Value visitVariableExpr(VariableExpr* expr) override;
+        Value visitAssignExpr(AssignExpr* expr) override;
+        Value visitCallExpr(CallExpr* expr) override;
+
+        void visitExpressionStmt(ExpressionStmt* stmt) override;
+        void visitPrintStmt(PrintStmt* stmt) override;
+        void visitVarStmt(VarStmt* stmt) override;
+        void visitIfStmt(IfStmt* stmt) override;
+        void visitBlockStmt(BlockStmt* stmt) override;
+
+    private:
+        Chunk chunk;
+        size_t depth = 0;
+};
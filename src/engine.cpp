@@ -0,0 +1,171 @@
+#include "simplelang.h"
+#include "cache.h"
+#include "closure.h"
+#include "interpreter.h"
+#include "program.h"
+#include "resolver.h"
+#include "serialize.h"
+#include "vm.h"
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+namespace simplelang {
+
+static constexpr size_t DEFAULT_CACHE_ENTRIES = 512;
+
+Engine::Engine(Backend backend)
+: backend{backend}, scripts{std::make_unique<ScriptCache>(DEFAULT_CACHE_ENTRIES)} {}
+
+Engine::~Engine() = default;
+
+void Engine::setCacheCapacity(size_t entries) {
+    scripts->setCapacity(entries);
+}
+
+void Engine::setCacheDirectory(std::string directory) {
+    cacheDirectory = std::move(directory);
+}
+
+std::string Engine::imagePath(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.slc", static_cast<unsigned long long>(key));
+    return cacheDirectory + "/" + name;
+}
+
+// Any image that is missing, stale, corrupt or refers to a native this engine
+// does not have is ignored; the caller then compiles from source.
+std::shared_ptr<Program> Engine::loadImageFile(uint64_t key, std::string_view source,
+                                               const std::vector<std::string>& inputs) const {
+    auto program = std::make_shared<Program>();
+    if (!program->image.open(imagePath(key)) || !isCompiledImage(program->image.text())) {
+        return nullptr;
+    }
+    try {
+        ImageInfo info = loadImage(*program, program->image.text(), &natives);
+        if (info.sourceKey != key || info.source != source || info.inputs != inputs) {
+            return nullptr;
+        }
+    } catch (std::exception&) {
+        return nullptr;
+    }
+    program->source = std::string(source);
+    lowerProgram(*program, backend);
+    return program;
+}
+
+// Written to a temporary file and renamed into place, so a concurrent reader
+// never sees a partial image. Failures only cost the next process a compile.
+void Engine::storeImageFile(uint64_t key, std::string_view source, const std::vector<std::string>& inputs,
+                            Program& program) const {
+    ImageInfo info;
+    info.sourceKey = key;
+    info.source = source;
+    info.inputs = inputs;
+    std::string image = writeImage(program, info);
+
+    std::string path = imagePath(key);
+    // Per-thread name, since two workers may compile the same script.
+    std::string temporary = path + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+    std::ofstream file(temporary, std::ios::binary);
+    file.write(image.data(), static_cast<std::streamsize>(image.size()));
+    file.close();
+    if (!file || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+    }
+}
+
+void Engine::registerNative(std::string name, int arity, NativeFunction function) {
+    natives.define(std::move(name), arity, std::move(function));
+}
+
+Script Engine::compile(std::string_view source, std::vector<std::string> inputs) {
+    // run() binds the i-th value to the i-th slot, so a repeated name would
+    // leave a value nothing reads.
+    for (size_t i = 0; i < inputs.size(); i++) {
+        for (size_t j = 0; j < i; j++) {
+            if (inputs[i] == inputs[j]) {
+                throw std::runtime_error("Duplicate input name: " + inputs[i]);
+            }
+        }
+    }
+
+    uint64_t key = scriptKey(source, inputs);
+    Script cached = scripts->find(key, source, inputs);
+    if (cached.valid()) {
+        return cached;
+    }
+
+    std::shared_ptr<Program> program;
+    if (!cacheDirectory.empty()) {
+        program = loadImageFile(key, source, inputs);
+    }
+    if (program == nullptr) {
+        program = std::make_shared<Program>();
+        program->source = std::string(source);
+
+        Resolver resolver{&natives};
+        for (const std::string& name: inputs) {
+            resolver.declareGlobal(name);
+        }
+        buildProgram(*program, program->source, resolver, backend);
+        if (!cacheDirectory.empty()) {
+            storeImageFile(key, source, inputs, *program);
+        }
+    }
+
+    Script script;
+    script.program = std::move(program);
+    script.inputNames = std::move(inputs);
+    scripts->insert(key, script);
+    return script;
+}
+
+void Engine::run(const Script& script, const std::vector<Value>& inputs, OutputSink* out) const {
+    if (!script.valid()) {
+        throw std::runtime_error("Script has not been compiled");
+    }
+    if (inputs.size() != script.inputNames.size()) {
+        throw std::runtime_error("Script expects " + std::to_string(script.inputNames.size()) +
+                                 " inputs but got " + std::to_string(inputs.size()));
+    }
+    // Output written to the shared stdout sink is flushed before returning,
+    // even on error, so it stays in order with whatever the host prints.
+    struct FlushStandardOutput {
+        bool active;
+        ~FlushStandardOutput() {
+            if (active) {
+                standardOutput().flush();
+            }
+        }
+    } flushOnExit{out == nullptr};
+
+    Program& program = *script.program;
+    if (backend == Backend::Bytecode) {
+        VM vm{&natives, out};
+        for (size_t i = 0; i < inputs.size(); i++) {
+            vm.bind(static_cast<uint32_t>(i), inputs[i]);
+        }
+        vm.run(program.chunk);
+    } else if (backend == Backend::Closure) {
+        ClosureRunner runner{&natives, out};
+        for (size_t i = 0; i < inputs.size(); i++) {
+            runner.bind(static_cast<uint32_t>(i), inputs[i]);
+        }
+        runner.run(program.closures);
+    } else {
+        Interpreter interpreter{&natives, out};
+        for (size_t i = 0; i < inputs.size(); i++) {
+            interpreter.bind(static_cast<uint32_t>(i), inputs[i]);
+        }
+        interpreter.interpret(program.statements, program.slots);
+    }
+}
+
+void Engine::eval(std::string_view source, const std::vector<std::string>& inputNames,
+                  const std::vector<Value>& inputs, OutputSink* out) {
+    run(compile(source, inputNames), inputs, out);
+}
+
+}
@@ -1,175 +1,233 @@
 #pragma once
 
-#include <memory>
-#include <any>
 #include <optional>
 
+#include "arena.h"
 #include "token.h"
+#include "value.h"
 
 class ExprVisitor {
     public:
-        virtual std::any visitLiteralExpr(class LiteralExpr*) = 0;
-        virtual std::any visitUnaryExpr(class UnaryExpr*) = 0;
-        virtual std::any visitBinaryExpr(class BinaryExpr*) = 0;
-        virtual std::any visitVariableExpr(class VariableExpr*) = 0;
+        virtual Value visitLiteralExpr(class LiteralExpr*) = 0;
+        virtual Value visitUnaryExpr(class UnaryExpr*) = 0;
+        virtual Value visitBinaryExpr(class BinaryExpr*) = 0;
+        virtual Value visitVariableExpr(class VariableExpr*) = 0;
+        virtual Value visitAssignExpr(class AssignExpr*) = 0;
+        virtual Value visitCallExpr(class CallExpr*) = 0;
 };
 
 class Expr {
     public:
-        virtual std::any accept(ExprVisitor*) = 0;
+        virtual Value accept(ExprVisitor*) = 0;
 };
 
 class LiteralExpr : public Expr {
     public:
-        LiteralExpr(std::any value)
-        : value{value} {}
+        // A runtime string, e.g. a folded concatenation, is copied into an
+        // interned one: the AST does not hold counted references, and cached
+        // scripts are shared across threads.
+        LiteralExpr(Value value)
+        : value{value.isStringObject() ? Value::string(value.asString()) : value} {}
 
-        std::any accept(ExprVisitor* visitor) override {
+        Value accept(ExprVisitor* visitor) override {
             return visitor->visitLiteralExpr(this);
         }
-        std::any& getValue() { return value; }
+        Value getValue() const { return value; }
     private:
-        std::any value;
+        Value value;
 };
 
 class UnaryExpr : public Expr {
     public:
-        UnaryExpr(Token op, std::unique_ptr<Expr>&& right)
-        : op{op}, right{std::move(right)} {}
+        UnaryExpr(Token op, Expr* right)
+        : op{op}, right{right} {}
 
-        std::any accept(ExprVisitor* visitor) override {
+        Value accept(ExprVisitor* visitor) override {
             return visitor->visitUnaryExpr(this);
         }
         Token& getOp() { return op; }
-        std::unique_ptr<Expr>& getRight() { return right; }
+        Expr*& getRight() { return right; }
     private:
         Token op;
-        std::unique_ptr<Expr> right;
+        Expr* right;
 };
 
 class BinaryExpr : public Expr {
     public:
-        BinaryExpr(std::unique_ptr<Expr>&& left, Token op, std::unique_ptr<Expr>&& right)
-        : left{std::move(left)}, op{op}, right{std::move(right)} {}
+        BinaryExpr(Expr* left, Token op, Expr* right)
+        : left{left}, op{op}, right{right} {}
 
-        std::any accept(ExprVisitor* visitor) override {
+        Value accept(ExprVisitor* visitor) override {
             return visitor->visitBinaryExpr(this);
         }
-        std::unique_ptr<Expr>& getLeft() { return left; }
+        Expr*& getLeft() { return left; }
          Token& getOp() { return op; }
-        std::unique_ptr<Expr>& getRight() { return right; }
+        Expr*& getRight() { return right; }
     private:
-        std::unique_ptr<Expr> left;
+        Expr* left;
          Token op;
-        std::unique_ptr<Expr> right;
+        Expr* right;
 };
 
 class StmtVisitor {
     public:
-        virtual std::any visitExpressionStmt(class ExpressionStmt*) = 0;
-        virtual std::any visitPrintStmt(class PrintStmt*) = 0;
-        virtual std::any visitVarStmt(class VarStmt*) = 0;
-        virtual std::any visitIfStmt(class IfStmt*) = 0;
-        virtual std::any visitBlockStmt(class BlockStmt*) = 0;
+        virtual void visitExpressionStmt(class ExpressionStmt*) = 0;
+        virtual void visitPrintStmt(class PrintStmt*) = 0;
+        virtual void visitVarStmt(class VarStmt*) = 0;
+        virtual void visitIfStmt(class IfStmt*) = 0;
+        virtual void visitBlockStmt(class BlockStmt*) = 0;
 };
 
 class Stmt {
     public:
-        virtual std::any accept(StmtVisitor*) = 0;
+        virtual void accept(StmtVisitor*) = 0;
+
+        // Source line of the statement's first token.
+        uint32_t getLine() const { return line; }
+        void setLine(uint32_t l) { line = l; }
+
+    private:
+        uint32_t line = 0;
 };
 
 class VarStmt : public Stmt {
     public:
-        VarStmt(Token name, std::unique_ptr<Expr>&& initializer)
-        : name{name}, initializer{std::move(initializer)} {}
+        VarStmt(Token name, Expr* initializer)
+        : name{name}, initializer{initializer} {}
 
-        std::any accept(StmtVisitor* visitor) override {
+        void accept(StmtVisitor* visitor) override {
             return visitor->visitVarStmt(this);
         }
 
         Token& getName() { return name; }
-        std::unique_ptr<Expr>& getInitializer() { return initializer; }
+        Expr*& getInitializer() { return initializer; }
+        uint32_t getSlot() const { return slot; }
+        void setSlot(uint32_t s) { slot = s; }
 
     private:
         Token name;
-        std::unique_ptr<Expr> initializer;
+        Expr* initializer;
+        uint32_t slot = 0;
 };
 
 class ExpressionStmt : public Stmt {
     public:
-        ExpressionStmt(std::unique_ptr<Expr>&& expression)
-        : expression{std::move(expression)} {}
+        ExpressionStmt(Expr* expression)
+        : expression{expression} {}
 
-        std::any accept(StmtVisitor* visitor) override {
+        void accept(StmtVisitor* visitor) override {
             return visitor->visitExpressionStmt(this);
         }
-        std::unique_ptr<Expr>& getExpression() { return expression; }
+        Expr*& getExpression() { return expression; }
     private:
-        std::unique_ptr<Expr> expression;
+        Expr* expression;
 };
 class VariableExpr : public Expr {
     public:
         VariableExpr(Token name)
         : name{name} {}
 
-        std::any accept(ExprVisitor* visitor) override {
+        Value accept(ExprVisitor* visitor) override {
             return visitor->visitVariableExpr(this);
         }
 
         Token& getName() { return name; }
+        uint32_t getSlot() const { return slot; }
+        void setSlot(uint32_t s) { slot = s; }
 
     private:
         Token name;
+        uint32_t slot = 0;
+};
+
+class AssignExpr : public Expr {
+    public:
+        AssignExpr(Token name, Expr* value)
+        : name{name}, value{value} {}
+
+        Value accept(ExprVisitor* visitor) override {
+            return visitor->visitAssignExpr(this);
+        }
+
+        Token& getName() { return name; }
+        Expr*& getValue() { return value; }
+        uint32_t getSlot() const { return slot; }
+        void setSlot(uint32_t s) { slot = s; }
+
+    private:
+        Token name;
+        Expr* value;
+        uint32_t slot = 0;
+};
+
+class CallExpr : public Expr {
+    public:
+        CallExpr(Token callee, ArenaSpan<Expr*> arguments)
+        : callee{callee}, arguments{arguments} {}
+
+        Value accept(ExprVisitor* visitor) override {
+            return visitor->visitCallExpr(this);
+        }
+
+        Token& getCallee() { return callee; }
+        ArenaSpan<Expr*>& getArguments() { return arguments; }
+        uint32_t getNative() const { return native; }
+        void setNative(uint32_t n) { native = n; }
+
+    private:
+        Token callee;
+        ArenaSpan<Expr*> arguments;
+        uint32_t native = 0;
 };
 
 class PrintStmt : public Stmt {
     public:
-        PrintStmt(std::unique_ptr<Expr>&& expression)
-        : expression{std::move(expression)} {}
+        PrintStmt(Expr* expression)
+        : expression{expression} {}
 
-        std::any accept(StmtVisitor* visitor) override {
+        void accept(StmtVisitor* visitor) override {
             return visitor->visitPrintStmt(this);
         }
-        std::unique_ptr<Expr>& getExpression() { return expression; }
+        Expr*& getExpression() { return expression; }
     private:
-        std::unique_ptr<Expr> expression;
+        Expr* expression;
 };
 
 class IfStmt : public Stmt {
     public:
-        IfStmt(std::unique_ptr<Expr>&& cond, std::unique_ptr<Stmt>&& then) : cond{std::move(cond)}, then{std::move(then)}, other_stmt_given{false} {}
+        IfStmt(Expr* cond, Stmt* then) : cond{cond}, then{then}, otherwise{nullptr}, other_stmt_given{false} {}
 
-        IfStmt(std::unique_ptr<Expr>&& cond, std::unique_ptr<Stmt>&& then, std::unique_ptr<Stmt>&& otherwise)
-        : cond{std::move(cond)}, then{std::move(then)}, otherwise{std::move(otherwise)}, other_stmt_given{true} {}
+        IfStmt(Expr* cond, Stmt* then, Stmt* otherwise)
+        : cond{cond}, then{then}, otherwise{otherwise}, other_stmt_given{true} {}
 
-        std::any accept(StmtVisitor* visitor) override {
+        void accept(StmtVisitor* visitor) override {
             return visitor->visitIfStmt(this);
         }
 
-        std::unique_ptr<Expr>& getCondition() { return cond; }
-        std::unique_ptr<Stmt>& getThen() { return then; }
-        std::unique_ptr<Stmt>& getOtherwise() { return otherwise; }
+        Expr*& getCondition() { return cond; }
+        Stmt*& getThen() { return then; }
+        Stmt*& getOtherwise() { return otherwise; }
         bool hasOtherStmt() const { return other_stmt_given; }
     private:
-        std::unique_ptr<Expr> cond;
-        std::unique_ptr<Stmt> then;
-        std::unique_ptr<Stmt> otherwise;
+        Expr* cond;
+        Stmt* then;
+        Stmt* otherwise;
         bool other_stmt_given;
 };
 
 class BlockStmt : public Stmt {
     public:
         // constructor
-        BlockStmt(std::vector<std::unique_ptr<Stmt>>&& stmts)
-        : stmts{std::move(stmts)}{}
+        BlockStmt(ArenaSpan<Stmt*> stmts)
+        : stmts{stmts}{}
         // accept method
-        std::any accept(StmtVisitor* visitor) override {
+        void accept(StmtVisitor* visitor) override {
             return visitor->visitBlockStmt(this);
         }
         // access functions
-        std::vector<std::unique_ptr<Stmt>>& getStatements(){
+        ArenaSpan<Stmt*>& getStatements(){
             return stmts;
         }
     private:
-        std::vector<std::unique_ptr<Stmt>> stmts;
+        ArenaSpan<Stmt*> stmts;
 };
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include "intern.h"
+#include <functional>
+#include <mutex>
+
+const InternedString* Interner::intern(std::string_view text) {
+    size_t hash = std::hash<std::string_view>{}(text);
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const InternedString* slot = slots[i];
+        if (slot == nullptr) {
+            strings.emplace_back(text, hash, static_cast<uint32_t>(strings.size()));
+            slots[i] = &strings.back();
+            if (strings.size() * 2 > slots.size()) {
+                grow();
+            }
+            return &strings.back();
+        }
+        if (slot->hash() == hash && slot->view() == text) {
+            return slot;
+        }
+    }
+}
+
+void Interner::grow() {
+    std::vector<const InternedString*> larger(slots.size() * 2, nullptr);
+    size_t mask = larger.size() - 1;
+    for (const InternedString& string: strings) {
+        size_t i = string.hash() & mask;
+        while (larger[i] != nullptr) {
+            i = (i + 1) & mask;
+        }
+        larger[i] = &string;
+    }
+    slots = std::move(larger);
+}
+
+const InternedString* internGlobal(std::string_view text) {
+    static std::mutex mutex;
+    static Interner strings;
+    std::lock_guard<std::mutex> lock{mutex};
+    return strings.intern(text);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Immutable string owned by an Interner. Each Interner holds one per
+// distinct text, so two strings from the same Interner are equal exactly
+// when their addresses are. The hash is computed once, when the string is
+// first interned.
+class InternedString {
+    public:
+        InternedString(std::string_view text, size_t hash, uint32_t id) : text{text}, hashValue{hash}, index{id} {}
+
+        std::string_view view() const { return text; }
+        size_t size() const { return text.size(); }
+        size_t hash() const { return hashValue; }
+        // Dense index in the owning Interner, 0 for the first string. Lets
+        // callers keep per-name data in a plain vector.
+        uint32_t id() const { return index; }
+
+    private:
+        std::string text;
+        size_t hashValue;
+        uint32_t index;
+};
+
+// Open-addressed table of InternedStrings. Strings are never removed and
+// never move. Not thread-safe; see internGlobal() for the shared table.
+class Interner {
+    public:
+        Interner() : slots(INITIAL_SLOTS, nullptr) {}
+        Interner(const Interner&) = delete;
+        Interner& operator=(const Interner&) = delete;
+
+        const InternedString* intern(std::string_view text);
+        size_t size() const { return strings.size(); }
+
+    private:
+        static constexpr size_t INITIAL_SLOTS = 256;
+
+        void grow();
+
+        std::deque<InternedString> strings;
+        // Power-of-two sized, at most half full.
+        std::vector<const InternedString*> slots;
+};
+
+// The process-wide table behind every string Value. Safe to call from any
+// thread; strings in it live until the process exits.
+const InternedString* internGlobal(std::string_view text);
@@ -1,97 +1,146 @@
+#pragma once
+
 #include "expr.h"
+#include "natives.h"
+#include "operators.h"
+#include "output.h"
+#include "profiler.h"
+#include "string_object.h"
 #include "token.h"
-#include <iostream>
-#include <memory>
+#include "value.h"
 #include <vector>
-#include <any>
 
 class Interpreter: public ExprVisitor, public StmtVisitor {
     public:
-        void interpret(std::vector<std::unique_ptr<Stmt>>& statements) {
+        Interpreter(const Natives* natives = nullptr, OutputSink* out = nullptr)
+        : natives{natives}, out{out != nullptr ? out : &standardOutput()} {}
+        Interpreter(const Interpreter&) = delete;
+        Interpreter& operator=(const Interpreter&) = delete;
+
+        ~Interpreter() {
+            for (const Value& value: frame) {
+                StringObject::release(value);
+            }
+            StringObject::collect();
+        }
+
+        // Reports every statement entered to `profiler`; null turns it off.
+        void setProfiler(Profiler* p) { profiler = p; }
+
+        // Presets a variable slot, e.g. a host-supplied input.
+        void bind(uint32_t slot, Value value) {
+            if (frame.size() <= slot) {
+                frame.resize(slot + 1);
+            }
+            storeValue(frame[slot], value);
+        }
+
+        // `slots` is the frame size reported by the Resolver.
+        void interpret(std::vector<Stmt*>& statements, size_t slots) {
+            if (frame.size() < slots) {
+                frame.resize(slots);
+            }
             for (auto& stmt: statements) {
                 execute(stmt);
             }
         }
+
+        // Totals since construction, for --stats. Every visit goes through
+        // execute() or evaluate(), so their sum is the number of dispatches.
+        uint64_t statementsExecuted() const { return executed; }
+        uint64_t expressionsEvaluated() const { return evaluated; }
+
     private:
-        void execute(std::unique_ptr<Stmt>& stmt) {
+        // No expression is half evaluated between statements, so that is
+        // where runtime strings nothing refers to any more are freed.
+        void execute(Stmt* stmt) {
+            executed++;
+            if (StringObject::collectionDue()) {
+                StringObject::collect();
+            }
+            if (profiler != nullptr) {
+                ProfileScope scope{*profiler, stmt->getLine()};
+                stmt->accept(this);
+                return;
+            }
             stmt->accept(this);
         }
 
-        std::any evaluate(std::unique_ptr<Expr>& expr) {
+        Value evaluate(Expr* expr) {
+            evaluated++;
             return expr->accept(this);
         }
 
-        std::any visitLiteralExpr(LiteralExpr* expr) override {
+        Value visitLiteralExpr(LiteralExpr* expr) override {
             return expr->getValue();
         }
 
-        std::any visitUnaryExpr(UnaryExpr* expr) override {
-            std::any ret = expr->getRight()->accept(this);
-            switch (expr->getOp().type) {
-                case TokenType::Minus: return -std::any_cast<float>(ret); break;
-                default: break;
-            }
-            return ret;
-        }
-
-        std::any visitBinaryExpr(BinaryExpr* expr) override {
-            float left = std::any_cast<float>(expr->getLeft()->accept(this));
-            float right = std::any_cast<float>(expr->getRight()->accept(this));
-            float ret = 0;
-            switch (expr->getOp().type) {
-                case TokenType::Plus: ret = left + right; break;
-                case TokenType::Minus: ret =  left - right; break;
-                case TokenType::Star: ret = left * right; break;
-                case TokenType::Slash: {
-                    if (right == 0)
-                        throw std::runtime_error("right operand is 0");
-                    ret = left / right;
-                } break;
-                case TokenType::Less: ret = (left < right); break;
-                case TokenType::LessEqual: ret = (left <= right); break;
-                case TokenType::Greater: ret = (left > right); break;
-                case TokenType::GreaterEqual: ret = (left >= right); break;
-                case TokenType::EqualEqual: ret = (left == right); break;
-                default: break;
-            }
-            return ret;
+        Value visitUnaryExpr(UnaryExpr* expr) override {
+            return unaryOp(expr->getOp().type, evaluate(expr->getRight()));
+        }
+
+        Value visitBinaryExpr(BinaryExpr* expr) override {
+            Value left = evaluate(expr->getLeft());
+            Value right = evaluate(expr->getRight());
+            return binaryOp(expr->getOp().type, left, right);
         }
 
-        std::any visitExpressionStmt(ExpressionStmt* stmt) override {
+        void visitExpressionStmt(ExpressionStmt* stmt) override {
             evaluate(stmt->getExpression());
-            return nullptr;
         }
 
-        std::any visitPrintStmt(PrintStmt* stmt) override {
-            std::any value = evaluate(stmt->getExpression());
-            if (value.type() == typeid(float)) {
-                std::cout << std::any_cast<float>(value);
-            }
-            if (value.type() == typeid(std::string)) {
-                std::cout << std::any_cast<std::string>(value);
+        void visitPrintStmt(PrintStmt* stmt) override {
+            printValue(*out, evaluate(stmt->getExpression()));
+        }
+
+        void visitVarStmt(VarStmt* stmt) override {
+            Value value = Value::nil();
+            if (stmt->getInitializer() != nullptr) {
+                value = evaluate(stmt->getInitializer());
             }
-            return nullptr;
+            storeValue(frame[stmt->getSlot()], value);
+        }
+
+        Value visitVariableExpr(VariableExpr* expr) override {
+            return frame[expr->getSlot()];
         }
 
-        std::any visitVarStmt(VarStmt*) override {}
-        std::any visitVariableExpr(VariableExpr*) override {}
+        Value visitAssignExpr(AssignExpr* expr) override {
+            Value value = evaluate(expr->getValue());
+            storeValue(frame[expr->getSlot()], value);
+            return value;
+        }
 
-        std::any visitBlockStmt(BlockStmt* stmt) override {
+        Value visitCallExpr(CallExpr* expr) override {
+            std::vector<Value> arguments;
+            arguments.reserve(expr->getArguments().size());
+            for (Expr* argument: expr->getArguments()) {
+                arguments.push_back(evaluate(argument));
+            }
+            return (*natives)[expr->getNative()].function(arguments.data(), arguments.size());
+        }
+
+        void visitBlockStmt(BlockStmt* stmt) override {
             for (auto& s: stmt->getStatements()) {
-                s->accept(this);
+                execute(s);
             }
-            return nullptr;
         }
 
-        std::any visitIfStmt(IfStmt* stmt) override {
-            auto condition = std::any_cast<float>(evaluate(stmt->getCondition()));
-            if (condition == 1.0) {
+        void visitIfStmt(IfStmt* stmt) override {
+            if (evaluate(stmt->getCondition()).isTruthy()) {
                 execute(stmt->getThen());
             } else {
                 if (stmt->hasOtherStmt()) {
                     execute(stmt->getOtherwise());
                 }
             }
-            return nullptr;
         }
+
+    private:
+        const Natives* natives;
+        OutputSink* out;
+        Profiler* profiler = nullptr;
+        std::vector<Value> frame;
+        uint64_t executed = 0;
+        uint64_t evaluated = 0;
 };
\ No newline at end of file
@@ -1,63 +1,100 @@
 #include "lexer.h"
+#include "scan.h"
+#include <algorithm>
+#include <cctype>
+#include <thread>
 
-Token Lexer::nextToken() {
-    if (peek() == '\0') {
-        return Token(TokenType::Eof, "");
+// Keywords are uniquely identified by (first char, last char, length), so a
+// hash over those three, with multipliers searched for at compile time, maps
+// every keyword to its own slot. A lookup is one hash and one compare.
+static constexpr size_t KEYWORD_TABLE_SIZE = 64;
+
+static constexpr size_t keywordHash(std::string_view word, uint32_t seed) {
+    uint32_t first = static_cast<unsigned char>(word.front());
+    uint32_t last = static_cast<unsigned char>(word.back());
+    return (first * (seed & 0xff) + last * (seed >> 8) + static_cast<uint32_t>(word.size())) & (KEYWORD_TABLE_SIZE - 1);
+}
+
+struct KeywordTable {
+    uint32_t seed;
+    Keyword slots[KEYWORD_TABLE_SIZE];
+};
+
+static constexpr KeywordTable buildKeywordTable() {
+    for (uint32_t seed = 0x101; seed < 0x10000; seed++) {
+        KeywordTable table{seed, {}};
+        bool collision = false;
+        for (const Keyword& keyword: KEYWORDS) {
+            Keyword& slot = table.slots[keywordHash(keyword.text, seed)];
+            if (!slot.text.empty()) {
+                collision = true;
+                break;
+            }
+            slot = keyword;
+        }
+        if (!collision) {
+            return table;
+        }
     }
+    return KeywordTable{0, {}};
+}
+
+static constexpr KeywordTable keywordTable = buildKeywordTable();
+static_assert(keywordTable.seed != 0, "no collision-free seed for the keyword table");
 
+Token Lexer::nextToken() {
     skipWhitespace();
 
     start = current;
+    tokenLine = line;
+
+    if (current >= input.size()) {
+        return makeToken(TokenType::Eof);
+    }
 
     auto ch = advance();
 
     switch (ch) {
-        case '(': return Token(TokenType::LeftParen, "("); break;
-        case ')': return Token(TokenType::RightParen, ")"); break;
-        case '{': return Token(TokenType::LeftBrace, "{"); break;
-        case '}': return Token(TokenType::RightBrace, "}"); break;
-        case ';': return Token(TokenType::Semicolon, ";"); break;
-        case ',': return Token(TokenType::Comma, ","); break;
-        case '.': return Token(TokenType::Dot, "."); break;
-        case '-': return Token(TokenType::Minus, "-"); break;
-        case '+': return Token(TokenType::Plus, "+"); break;
-        case '*': return Token(TokenType::Star, "*"); break;
+        case '(': return makeToken(TokenType::LeftParen); break;
+        case ')': return makeToken(TokenType::RightParen); break;
+        case '{': return makeToken(TokenType::LeftBrace); break;
+        case '}': return makeToken(TokenType::RightBrace); break;
+        case ';': return makeToken(TokenType::Semicolon); break;
+        case ',': return makeToken(TokenType::Comma); break;
+        case '.': return makeToken(TokenType::Dot); break;
+        case '-': return makeToken(TokenType::Minus); break;
+        case '+': return makeToken(TokenType::Plus); break;
+        case '*': return makeToken(TokenType::Star); break;
         case '=': {
             if (peek() == '=') {
                 advance();
-                return Token(TokenType::EqualEqual,"==");
+                return makeToken(TokenType::EqualEqual);
             }
-            return Token(TokenType::Equal, "=");
+            return makeToken(TokenType::Equal);
         } break;
         case '!': {
             if (peek() == '=') {
                 advance();
-                return Token(TokenType::BangEqual, "!=");
+                return makeToken(TokenType::BangEqual);
             }
-            return Token(TokenType::Bang, "!");
+            return makeToken(TokenType::Bang);
         } break;
         case '<': {
             if (peek() == '=') {
                 advance();
-                return Token(TokenType::LessEqual, "<=");
+                return makeToken(TokenType::LessEqual);
             }
-            return Token(TokenType::Less, "<");
+            return makeToken(TokenType::Less);
         } break;
         case '>': {
             if (peek() == '=') {
                 advance();
-                return Token(TokenType::GreaterEqual, ">=");
+                return makeToken(TokenType::GreaterEqual);
             }
-            return Token(TokenType::Greater, ">");
+            return makeToken(TokenType::Greater);
         } break;
         case '/': {
-            if (peek() == '/') {
-                while (peek() != '\n' && peek() != '\0') {
-                    advance();
-                }
-                return nextToken();
-            }
-            return Token(TokenType::Slash, "/");
+            return makeToken(TokenType::Slash);
         } break;
         case '"': { return string(); } break;
         default: {
@@ -66,12 +103,16 @@ Token Lexer::nextToken() {
             } else if (isalpha(ch)) {
                 return identifier();
             } else {
-                return Token(TokenType::Unknown, std::string(1, ch));
+                return makeToken(TokenType::Unknown);
             }
         }
     }
 }
 
+Token Lexer::makeToken(TokenType type) {
+    return Token(type, input.substr(start, current - start), tokenLine);
+}
+
 std::vector<Token> Lexer::getTokens() {
     std::vector<Token> tokens;
     while (true) {
@@ -84,18 +125,28 @@ std::vector<Token> Lexer::getTokens() {
     return tokens;
 }
 
+// Skips whitespace and // comments. Single separating spaces are handled
+// inline; longer runs go to the bulk scanners.
 void Lexer::skipWhitespace() {
     while (true) {
-        auto ch = peek();
-        switch (ch) {
-            case ' ':
+        switch (peek()) {
+            case ' ': {
+                char next = peek_next();
+                if (next != ' ' && next != '\t' && next != '\r' && next != '\n') {
+                    current++;
+                    break;
+                }
+            } [[fallthrough]];
             case '\t':
-            case '\r': {
-                advance();
-            } break;
+            case '\r':
             case '\n': {
-                line++;
-                advance();
+                current = scan::skipWhitespace(input.data(), input.size(), current, line);
+            } break;
+            case '/': {
+                if (peek_next() != '/') {
+                    return;
+                }
+                skipComment();
             } break;
             default: {
                 return;
@@ -104,20 +155,9 @@ void Lexer::skipWhitespace() {
     }
 }
 
+// Leaves the terminating newline for skipWhitespace so it is counted once.
 void Lexer::skipComment() {
-    while (true) {
-        auto ch = peek();
-        switch (ch) {
-            case '\n': {
-                line++;
-                advance();
-                return;
-            } break;
-            default: {
-                advance();
-            } break;
-        }
-    }
+    current = scan::findNewline(input.data(), input.size(), current);
 }
 
 char Lexer::peek_next() {
@@ -143,109 +183,13 @@ Token Lexer::identifier() {
     while (isalpha(peek()) || isdigit(peek())) {
         advance();
     }
-    std::string str = input.substr(start, current - start);
+    std::string_view str = input.substr(start, current - start);
 
-    switch (str[0]) {
-        case 'a': {
-            if (str == "and") {
-                return Token(TokenType::And, str);
-            }
-        }; break;
-        case 'b': {
-            if (str == "break") {
-                return Token(TokenType::Break, str);
-            }
-        }; break;
-        case 'c': {
-            if (str == "class") {
-                return Token(TokenType::Class, str);
-            } else if (str == "continue") {
-                return Token(TokenType::Continue, str);
-            }
-        }; break;
-        case 'd': {
-            if (str == "do") {
-                return Token(TokenType::Do, str);
-            }
-        }; break;
-        case 'e': {
-            if (str == "else") {
-                return Token(TokenType::Else, str);
-            } else if (str == "elseif") {
-                return Token(TokenType::ElseIf, str);
-            }
-        }; break;
-        case 'f': {
-            if (str == "false") {
-                return Token(TokenType::False, str);
-            } else if (str == "for") {
-                return Token(TokenType::For, str);
-            } else if (str == "fun") {
-                return Token(TokenType::Fun, str);
-            }
-        }; break;
-        case 'i': {
-            if (str == "if") {
-                return Token(TokenType::If, str);
-            } else if (str == "in") {
-                return Token(TokenType::In, str);
-            }
-        }; break;
-        case 'l': {
-            if (str == "let") {
-                return Token(TokenType::Let, str);
-            }
-        }; break;
-        case 'n': {
-            if (str == "nil") {
-                return Token(TokenType::Nil, str);
-            }
-        }; break;
-        case 'o': {
-            if (str == "or") {
-                return Token(TokenType::Or, str);
-            }
-        }; break;
-        case 'p': {
-            if (str == "print") {
-                return Token(TokenType::Print, str);
-            }
-        }; break;
-        case 'r': {
-            if (str == "return") {
-                return Token(TokenType::Return, str);
-            }
-        }; break;
-        case 's': {
-            if (str == "super") {
-                return Token(TokenType::Super, str);
-            } else if (str == "static") {
-                return Token(TokenType::Static, str);
-            } else if (str == "struct") {
-                return Token(TokenType::Struct, str);
-            } else if (str == "switch") {
-                return Token(TokenType::Switch, str);
-            }
-        }; break;
-        case 't': {
-            if (str == "true") {
-                return Token(TokenType::True, str);
-            } else if (str == "this") {
-                return Token(TokenType::This, str);
-            }
-        }; break;
-        case 'v': {
-            if (str == "var") {
-                return Token(TokenType::Var, str);
-            }
-        }; break;
-        case 'w': {
-            if (str == "while") {
-                return Token(TokenType::While, str);
-            }
-        }; break;
+    const Keyword& slot = keywordTable.slots[keywordHash(str, keywordTable.seed)];
+    if (slot.text == str) {
+        return makeToken(slot.type);
     }
-    return Token(TokenType::Identifier, str);
+    return makeToken(TokenType::Identifier);
 }
 
 Token Lexer::number() {
@@ -260,21 +204,111 @@ Token Lexer::number() {
         }
     }
 
-    std::string str = input.substr(start, current - start);
-    return Token(TokenType::Number, str, std::stof(str) );
+    return makeToken(TokenType::Number);
 }
 
 Token Lexer::string() {
-    while (peek() != '"' && peek() != '\0') {
-        if (peek() == '\n') {
-            line++;
+    current = scan::findQuote(input.data(), input.size(), current, line);
+    if (current >= input.size()) {
+        return Token(TokenType::Unknown, "Unterminated string", tokenLine);
+    }
+    advance();
+    return Token(TokenType::String, input.substr(start + 1, current - start - 2), tokenLine);
+}
+
+// Below this many bytes per chunk, thread start-up costs more than it saves.
+static constexpr size_t MIN_PARALLEL_CHUNK = 1 << 20;
+
+namespace {
+
+// Tokens starting in [begin, end). `first` and `stop` are where the first
+// token and the first token past the chunk start, with the lines there.
+struct LexChunk {
+    size_t begin;
+    size_t end;
+    std::vector<Token> tokens;
+    size_t first = 0;
+    uint32_t firstLine = 0;
+    size_t stop = 0;
+    uint32_t stopLine = 0;
+};
+
+}
+
+static void lexChunk(std::string_view input, LexChunk& chunk, uint32_t line) {
+    Lexer lexer{input};
+    lexer.current = chunk.begin;
+    lexer.line = line;
+    chunk.tokens.clear();
+    Token token = lexer.nextToken();
+    chunk.first = lexer.start;
+    chunk.firstLine = lexer.tokenLine;
+    while (token.type != TokenType::Eof && lexer.start < chunk.end) {
+        chunk.tokens.push_back(token);
+        token = lexer.nextToken();
+    }
+    chunk.stop = lexer.start;
+    chunk.stopLine = lexer.tokenLine;
+}
+
+std::vector<Token> lexParallel(std::string_view input, unsigned threads) {
+    size_t count = std::min<size_t>(std::max(threads, 1u), input.size() / MIN_PARALLEL_CHUNK);
+    if (count <= 1) {
+        Lexer lexer{input};
+        std::vector<Token> tokens = lexer.getTokens();
+        tokens.push_back(lexer.nextToken());
+        return tokens;
+    }
+
+    std::vector<LexChunk> chunks;
+    size_t begin = 0;
+    for (size_t i = 1; i <= count && begin < input.size(); i++) {
+        size_t end = input.size();
+        if (i < count) {
+            size_t newline = input.find('\n', std::max(begin, input.size() / count * i));
+            end = newline == std::string_view::npos ? input.size() : newline + 1;
         }
-        advance();
+        chunks.push_back(LexChunk{begin, end, {}});
+        begin = end;
     }
-    if (peek() == '\0') {
-        return Token(TokenType::Unknown, "Unterminated string");
+
+    // Every chunk but the first starts out with its lines counted from 1.
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < chunks.size(); i++) {
+        workers.emplace_back([&, i] { lexChunk(input, chunks[i], 1); });
     }
-    advance();
-    std::string str = input.substr(start + 1, current - start - 2);
-    return Token(TokenType::String, str, str);
+    lexChunk(input, chunks[0], 1);
+    for (std::thread& worker: workers) {
+        worker.join();
+    }
+
+    // A chunk is right if its first token starts exactly where the previous
+    // chunk stopped. If not, the split fell inside a string and the chunk is
+    // lexed again from the previous stop, this time with the real line.
+    size_t total = 1;
+    for (const LexChunk& chunk: chunks) {
+        total += chunk.tokens.size();
+    }
+    std::vector<Token> tokens;
+    tokens.reserve(total);
+    size_t stop = 0;
+    uint32_t stopLine = 1;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        LexChunk& chunk = chunks[i];
+        uint32_t offset = 0;
+        if (i > 0 && chunk.first == stop) {
+            offset = stopLine - chunk.firstLine;
+        } else if (i > 0) {
+            chunk.begin = stop;
+            lexChunk(input, chunk, stopLine);
+        }
+        for (Token& token: chunk.tokens) {
+            token.line += offset;
+            tokens.push_back(token);
+        }
+        stop = chunk.stop;
+        stopLine = chunk.stopLine + offset;
+    }
+    tokens.push_back(Token(TokenType::Eof, input.substr(input.size()), stopLine));
+    return tokens;
 }
@@ -1,18 +1,19 @@
 #pragma once
 
 #include "token.h"
-#include <string>
+#include <string_view>
 #include <vector>
 
 class Lexer {
     public:
-        std::string input;
+        std::string_view input;
         size_t start;
         size_t current;
-        size_t line;
+        uint32_t line;
+        uint32_t tokenLine;
 
     public:
-        Lexer(const std::string& input) : input(input), start(0), current(0), line(1) {}
+        Lexer(std::string_view input) : input(input), start(0), current(0), line(1), tokenLine(1) {}
 
         Token nextToken();
         std::vector<Token> getTokens();
@@ -24,8 +25,16 @@ class Lexer {
         char peek_next();
         char peek();
         char advance();
+        Token makeToken(TokenType type);
 
         Token identifier();
         Token number();
         Token string();
 };
+
+// Same tokens as lexing `input` with one Lexer, followed by an Eof token, but
+// produced by up to `threads` threads. The input is split at newlines on the
+// guess that none of them is inside a string; each chunk is lexed on its
+// own, and a chunk whose guess turns out wrong is lexed again from where the
+// previous chunk really ended. Small inputs are lexed on the calling thread.
+std::vector<Token> lexParallel(std::string_view input, unsigned threads);
@@ -1,62 +1,184 @@
-#include <iostream>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
-#include "lexer.h"
-#include "parser.h"
-#include "interpreter.h"
+#include <iostream>
+#include <vector>
+#include "batch.h"
+#include "cache.h"
+#include "serialize.h"
+#include "session.h"
+#include "source.h"
 
-void eval(const std::string& code) {
-    Lexer lexer{code};
-    auto tokens = lexer.getTokens();
+struct Options {
+    simplelang::Backend backend = simplelang::Backend::Tree;
+    bool compile = false;
+    bool batch = false;
+    unsigned jobs = 0;
+    unsigned lexThreads = 1;
+    // "", "text" or "json".
+    std::string stats;
+    // Folded-stack output of --profile; empty when not profiling.
+    std::string profile;
+};
 
-    Parser parser{tokens};
+void repl(const Options& options) {
 
-    try {
-        auto statements = parser.parse();
-        Interpreter interpreter;
-        interpreter.interpret(statements);
-    } catch (std::exception& e) {
-        std::cout << e.what() << std::endl;
+    Session session{options.backend};
+    std::string code;
+
+    while (true) {
+        standardOutput().write(">> ");
+        standardOutput().flush();
+        if (!std::getline(std::cin, code)) {
+            break;
+        }
+        session.eval(std::move(code));
     }
 }
 
-void repl() {
+void read(const std::string& path, const Options& options) {
 
-    std::string code;
+    SourceFile source;
 
-    while (true) {
-        std::cout << ">> ";
-        std::getline(std::cin, code);
-        eval(code);
+    if (!source.open(path)) {
+        std::cerr << "Could not open file: " << path << std::endl;
+        return;
     }
-}
 
-void read(const std::string& path) {
+    Stats stats;
+    Profiler profiler{path};
+    bool profiling = !options.profile.empty();
+    Session session{options.backend, options.lexThreads, options.stats.empty() ? nullptr : &stats,
+                    profiling ? &profiler : nullptr};
+    if (profiling) {
+        profiler.start();
+    }
+    session.run(source.text());
+    if (profiling) {
+        profiler.stop();
+        standardOutput().flush();
+        profiler.writeFlat(std::cerr);
+        std::ofstream folded(options.profile);
+        profiler.writeFolded(folded);
+        if (!folded) {
+            std::cerr << "Could not write file: " << options.profile << std::endl;
+        }
+    }
 
-    std::string code;
+    if (!options.stats.empty()) {
+        standardOutput().flush();
+        if (options.stats == "json") {
+            stats.writeJson(std::cerr);
+        } else {
+            stats.writeText(std::cerr);
+        }
+    }
+}
+
+int compile(const std::string& path, const std::string& output, const Options& options) {
 
-    std::ifstream file(path);
+    SourceFile source;
 
-    if (!file.is_open()) {
+    if (!source.open(path)) {
         std::cerr << "Could not open file: " << path << std::endl;
-        return;
+        return 1;
     }
 
-    std::string line;
-    while (getline(file, line)) {
-        code += line;
+    std::string image;
+    try {
+        Program program;
+        Resolver resolver;
+        buildProgram(program, source.text(), resolver, simplelang::Backend::Tree, options.lexThreads);
+        ImageInfo info;
+        info.sourceKey = simplelang::scriptKey(source.text(), {});
+        info.source = source.text();
+        image = writeImage(program, info);
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
-    file.close();
 
-    eval(code);
+    std::string temporary = output + ".tmp";
+    std::ofstream file(temporary, std::ios::binary);
+    file.write(image.data(), static_cast<std::streamsize>(image.size()));
+    file.close();
+    if (!file || std::rename(temporary.c_str(), output.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        std::cerr << "Could not write file: " << output << std::endl;
+        return 1;
+    }
+    return 0;
 }
 
 int main(int argc, char** argv) {
 
-    switch (argc) {
-        case 1: repl(); break;
-        case 2: read(argv[1]); break;
+    // All script output goes through standardOutput(); iostreams are only
+    // used for stdin and diagnostics, so they need not stay in step with
+    // stdio.
+    std::ios::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+
+    Options options;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--vm") {
+            options.backend = simplelang::Backend::Bytecode;
+        } else if (arg == "--closures") {
+            options.backend = simplelang::Backend::Closure;
+        } else if (arg == "--stats" || arg == "--stats=text") {
+            options.stats = "text";
+        } else if (arg == "--stats=json") {
+            options.stats = "json";
+        } else if (arg == "--profile") {
+            options.profile = "simplelang.folded";
+        } else if (arg.rfind("--profile=", 0) == 0) {
+            options.profile = arg.substr(10);
+        } else if (arg == "--compile") {
+            options.compile = true;
+        } else if (arg == "--batch") {
+            options.batch = true;
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            options.jobs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--lex-threads" && i + 1 < argc) {
+            options.lexThreads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (!options.profile.empty() && options.backend != simplelang::Backend::Tree) {
+        std::cerr << "--profile needs the tree interpreter" << std::endl;
+        return -1;
+    }
+
+    if (options.compile) {
+        if (args.size() != 2) {
+            std::cerr << "usage: " << argv[0] << " --compile <script> <output>" << std::endl;
+            return -1;
+        }
+        return compile(args[0], args[1], options);
+    }
+
+    if (options.batch) {
+        if (args.size() != 1) {
+            std::cerr << "usage: " << argv[0] << " --batch <directory|manifest> [--jobs N]" << std::endl;
+            return -1;
+        }
+        try {
+            BatchOptions batch{options.backend, options.jobs};
+            return runBatch(batchScripts(args[0]), batch) == 0 ? 0 : 1;
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    switch (args.size()) {
+        case 0: repl(options); break;
+        case 1: read(args[0], options); break;
         default: return -1;
     }
 
     return 0;
-}
+}
\ No newline at end of file
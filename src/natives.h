@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "value.h"
+
+// Host functions callable from scripts as `name(args)`. Calls are bound to
+// an index by the Resolver, so nothing is looked up by name at runtime.
+// A native that builds a string returns StringObject::temporary(), not
+// make(), so the script's collector can free it.
+using NativeFunction = std::function<Value(const Value* args, size_t count)>;
+
+struct Native {
+    std::string name;
+    // Number of arguments, or -1 for any.
+    int arity;
+    NativeFunction function;
+};
+
+// Append-only, so indices handed out to compiled code stay valid. Not safe
+// to modify while scripts are running.
+class Natives {
+    public:
+        uint32_t define(std::string name, int arity, NativeFunction function) {
+            for (size_t i = 0; i < natives.size(); i++) {
+                if (natives[i].name == name) {
+                    natives[i].arity = arity;
+                    natives[i].function = std::move(function);
+                    return static_cast<uint32_t>(i);
+                }
+            }
+            natives.push_back(Native{std::move(name), arity, std::move(function)});
+            return static_cast<uint32_t>(natives.size() - 1);
+        }
+
+        // Returns the index of `name`, or -1 if it is not registered.
+        int64_t find(std::string_view name) const {
+            for (size_t i = 0; i < natives.size(); i++) {
+                if (natives[i].name == name) {
+                    return static_cast<int64_t>(i);
+                }
+            }
+            return -1;
+        }
+
+        const Native& operator[](uint32_t index) const { return natives[index]; }
+
+    private:
+        std::vector<Native> natives;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdexcept>
+#include "string_object.h"
+#include "token.h"
+#include "value.h"
+
+// Operator semantics shared by the interpreter, the VM and the constant folder.
+
+inline double numberOperand(Value value) {
+    if (!value.isNumber())
+        throw std::runtime_error("operands must be numbers");
+    return value.asNumber();
+}
+
+inline Value unaryOp(TokenType op, Value right) {
+    switch (op) {
+        case TokenType::Minus: return Value::number(-numberOperand(right));
+        default: break;
+    }
+    return right;
+}
+
+inline Value binaryOp(TokenType op, Value lhs, Value rhs) {
+    switch (op) {
+        case TokenType::EqualEqual: return Value::boolean(lhs == rhs);
+        case TokenType::BangEqual: return Value::boolean(lhs != rhs);
+        case TokenType::Plus: {
+            if (lhs.isString() && rhs.isString()) {
+                return concatStrings(lhs, rhs);
+            }
+        } break;
+        default: break;
+    }
+    double left = numberOperand(lhs);
+    double right = numberOperand(rhs);
+    switch (op) {
+        case TokenType::Plus: return Value::number(left + right);
+        case TokenType::Minus: return Value::number(left - right);
+        case TokenType::Star: return Value::number(left * right);
+        case TokenType::Slash: {
+            if (right == 0)
+                throw std::runtime_error("right operand is 0");
+            return Value::number(left / right);
+        } break;
+        case TokenType::Less: return Value::boolean(left < right);
+        case TokenType::LessEqual: return Value::boolean(left <= right);
+        case TokenType::Greater: return Value::boolean(left > right);
+        case TokenType::GreaterEqual: return Value::boolean(left >= right);
+        default: break;
+    }
+    return Value::nil();
+}
@@ -0,0 +1,127 @@
+#include "optimizer.h"
+#include "operators.h"
+#include <stdexcept>
+
+void ConstantFolder::fold(std::vector<Stmt*>& statements) {
+    for (Stmt*& stmt: statements) {
+        fold(stmt);
+    }
+    // Folded strings were copied into their LiteralExprs.
+    StringObject::collect();
+}
+
+Value ConstantFolder::fold(Expr*& expr) {
+    Value value = expr->accept(this);
+    if (constant && !literal) {
+        expr = arena.make<LiteralExpr>(value);
+    }
+    return value;
+}
+
+void ConstantFolder::fold(Stmt*& stmt) {
+    replacement = nullptr;
+    stmt->accept(this);
+    if (replacement != nullptr) {
+        stmt = replacement;
+        replacement = nullptr;
+    }
+}
+
+Value ConstantFolder::visitLiteralExpr(LiteralExpr* expr) {
+    constant = true;
+    literal = true;
+    return expr->getValue();
+}
+
+Value ConstantFolder::visitUnaryExpr(UnaryExpr* expr) {
+    Value right = fold(expr->getRight());
+    literal = false;
+    if (!constant) {
+        return Value::nil();
+    }
+    try {
+        return unaryOp(expr->getOp().type, right);
+    } catch (std::runtime_error&) {
+        constant = false;
+        return Value::nil();
+    }
+}
+
+Value ConstantFolder::visitBinaryExpr(BinaryExpr* expr) {
+    Value left = fold(expr->getLeft());
+    bool leftConstant = constant;
+    Value right = fold(expr->getRight());
+    literal = false;
+    if (!leftConstant || !constant) {
+        constant = false;
+        return Value::nil();
+    }
+    try {
+        return binaryOp(expr->getOp().type, left, right);
+    } catch (std::runtime_error&) {
+        constant = false;
+        return Value::nil();
+    }
+}
+
+Value ConstantFolder::visitVariableExpr(VariableExpr*) {
+    constant = false;
+    literal = false;
+    return Value::nil();
+}
+
+Value ConstantFolder::visitAssignExpr(AssignExpr* expr) {
+    fold(expr->getValue());
+    constant = false;
+    literal = false;
+    return Value::nil();
+}
+
+Value ConstantFolder::visitCallExpr(CallExpr* expr) {
+    for (Expr*& argument: expr->getArguments()) {
+        fold(argument);
+    }
+    constant = false;
+    literal = false;
+    return Value::nil();
+}
+
+void ConstantFolder::visitExpressionStmt(ExpressionStmt* stmt) {
+    fold(stmt->getExpression());
+}
+
+void ConstantFolder::visitPrintStmt(PrintStmt* stmt) {
+    fold(stmt->getExpression());
+}
+
+void ConstantFolder::visitVarStmt(VarStmt* stmt) {
+    if (stmt->getInitializer() != nullptr) {
+        fold(stmt->getInitializer());
+    }
+}
+
+void ConstantFolder::visitIfStmt(IfStmt* stmt) {
+    Value condition = fold(stmt->getCondition());
+    bool known = constant;
+    fold(stmt->getThen());
+    if (stmt->hasOtherStmt()) {
+        fold(stmt->getOtherwise());
+    }
+    if (!known) {
+        return;
+    }
+    if (condition.isTruthy()) {
+        replacement = stmt->getThen();
+    } else if (stmt->hasOtherStmt()) {
+        replacement = stmt->getOtherwise();
+    } else {
+        replacement = arena.make<BlockStmt>(ArenaSpan<Stmt*>{});
+        replacement->setLine(stmt->getLine());
+    }
+}
+
+void ConstantFolder::visitBlockStmt(BlockStmt* stmt) {
+    for (Stmt*& s: stmt->getStatements()) {
+        fold(s);
+    }
+}
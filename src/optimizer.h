@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include "arena.h"
+#include "expr.h"
+
+// Folds constant subtrees between parsing and execution: operators whose
+// operands are all literals become a single LiteralExpr, and an `if` with a
+// constant condition is replaced by the branch that would run. Expressions
+// that would fail at runtime (e.g. division by zero) are left in place so the
+// error is still raised if, and when, they execute.
+class ConstantFolder: public ExprVisitor, public StmtVisitor {
+    public:
+        ConstantFolder(AstArena& arena) : arena{arena} {}
+
+        void fold(std::vector<Stmt*>& statements);
+
+    private:
+        // Returns the folded value; only meaningful when `constant` is set.
+        Value fold(Expr*& expr);
+        void fold(Stmt*& stmt);
+
+        Value visitLiteralExpr(LiteralExpr* expr) override;
+        Value visitUnaryExpr(UnaryExpr* expr) override;
+        Value visitBinaryExpr(BinaryExpr* expr) override;
+        Value visitVariableExpr(VariableExpr* expr) override;
+        Value visitAssignExpr(AssignExpr* expr) override;
+        Value visitCallExpr(CallExpr* expr) override;
+
+        void visitExpressionStmt(ExpressionStmt* stmt) override;
+        void visitPrintStmt(PrintStmt* stmt) override;
+        void visitVarStmt(VarStmt* stmt) override;
+        void visitIfStmt(IfStmt* stmt) override;
+        void visitBlockStmt(BlockStmt* stmt) override;
+
+    private:
+        AstArena& arena;
+        // Result of the last expression visit.
+        bool constant = false;
+        bool literal = false;
+        // Set by a statement visit that wants its node swapped out.
+        Stmt* replacement = nullptr;
+};
@@ -0,0 +1,47 @@
+#include "output.h"
+
+#ifdef _WIN32
+#include <io.h>
+#define isatty _isatty
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
+
+FileSink::FileSink(std::FILE* file)
+: file{file}, lineBuffered{isatty(fileno(file)) != 0}, buffer{new char[BUFFER_SIZE]} {}
+
+FileSink::~FileSink() {
+    flush();
+}
+
+void FileSink::flush() {
+    if (used != 0) {
+        std::fwrite(buffer.get(), 1, used, file);
+        used = 0;
+    }
+    std::fflush(file);
+}
+
+// Writes that do not fit go out directly after whatever is already buffered,
+// rather than being copied through the buffer piece by piece.
+void FileSink::drain(std::string_view text) {
+    if (used != 0) {
+        std::fwrite(buffer.get(), 1, used, file);
+        used = 0;
+    }
+    if (text.size() >= BUFFER_SIZE) {
+        std::fwrite(text.data(), 1, text.size(), file);
+    } else {
+        std::memcpy(buffer.get(), text.data(), text.size());
+        used = text.size();
+    }
+    if (lineBuffered) {
+        flush();
+    }
+}
+
+OutputSink& standardOutput() {
+    static FileSink sink{stdout};
+    return sink;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "value.h"
+
+// Destination for `print`. Embedders pass their own sink to capture output;
+// the command line tool writes to std::cout.
+class OutputSink {
+    public:
+        virtual ~OutputSink() = default;
+        virtual void write(std::string_view text) = 0;
+        // Pushes anything buffered to its destination.
+        virtual void flush() {}
+};
+
+class StreamSink: public OutputSink {
+    public:
+        StreamSink(std::ostream& out) : out{out} {}
+
+        void write(std::string_view text) override {
+            out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        }
+        void flush() override { out.flush(); }
+
+    private:
+        std::ostream& out;
+};
+
+class StringSink: public OutputSink {
+    public:
+        void write(std::string_view text) override { buffer.append(text); }
+
+        const std::string& str() const { return buffer; }
+        void clear() { buffer.clear(); }
+
+    private:
+        std::string buffer;
+};
+
+// Collects output in one reusable buffer and hands it to a C stream in large
+// writes. A terminal is flushed at the end of every write that contains a
+// newline, so interactive output shows up line by line; anything else is
+// only flushed when the buffer fills, on flush(), or on destruction.
+class FileSink: public OutputSink {
+    public:
+        static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+        FileSink(std::FILE* file);
+        ~FileSink() override;
+        FileSink(const FileSink&) = delete;
+        FileSink& operator=(const FileSink&) = delete;
+
+        void write(std::string_view text) override {
+            if (text.size() > BUFFER_SIZE - used) {
+                drain(text);
+                return;
+            }
+            std::memcpy(buffer.get() + used, text.data(), text.size());
+            used += text.size();
+            if (lineBuffered && text.find('\n') != std::string_view::npos) {
+                flush();
+            }
+        }
+
+        void flush() override;
+
+    private:
+        void drain(std::string_view text);
+
+        std::FILE* file;
+        bool lineBuffered;
+        std::unique_ptr<char[]> buffer;
+        size_t used = 0;
+};
+
+// Process-wide sink for stdout, used whenever no other sink is given. The
+// command line tool writes all of its stdout through it.
+OutputSink& standardOutput();
+
+inline void printValue(OutputSink& out, Value value) {
+    if (value.isNumber()) {
+        char buffer[32];
+        out.write(std::string_view(buffer, formatNumber(buffer, sizeof(buffer), value.asNumber())));
+    } else if (value.isString()) {
+        out.write(value.asString());
+    } else if (value.isBool()) {
+        out.write(value.asBool() ? "true" : "false");
+    } else {
+        out.write("nil");
+    }
+}
@@ -1,42 +1,81 @@
 #include "parser.h"
+#include <charconv>
 #include <exception>
 #include <iostream>
 
 // BNF Grammar
 // Backus Naur Formr
 
-// program      -> statement* EOF;
+// program      -> declaration* EOF;
+// declaration  -> vardecl | statement;
 // statement    -> exprStmt | printStmt | IfStmt | BlockStmt;
 // vardecl      -> "var" IDENTIFIER ("=" expr)?";";
 // ifStmt       -> "if" expr stmt ("else if" stmt)* (else stmt)?;
-// blockStmt    -> ----
+// blockStmt    -> "{" declaration* "}";
 // exprStmt     -> expr ";";
 // printStmt    -> "print" expr ";";
-// expr         -> equality
+// expr         -> assignment;
+// assignment   -> IDENTIFIER "=" assignment | equality;
 // equality     -> comparison (("!=" | "==") comparison)*;
 // comparison   -> term ((">" | ">=" | "<" | "<=") term)*;
 // term         -> factor (("-" | "+") factor)*;
 // factor       -> UnaryExpr (("*" | "/") UnaryExpr)*;
-// UnaryExpr        -> ("+" | "-") UnaryExpr | primary;
-// primary      -> num | "(" expr ")";
+// UnaryExpr        -> ("+" | "-") UnaryExpr | call;
+// call         -> primary ("(" (expr ("," expr)*)? ")")?;
+// primary      -> num | string | "true" | "false" | IDENTIFIER | "(" expr ")";
+
+Parser::Parser(Lexer& lexer, AstArena& arena)
+: lexer{&lexer}, arena{arena} {
+    window[0] = lexer.nextToken();
+}
+
+Parser::Parser(const std::vector<Token>& tokens, AstArena& arena)
+: tokens{tokens.data()}, arena{arena} {
+    if (tokens.empty() || tokens.back().type != TokenType::Eof) {
+        throw std::runtime_error("Token stream must end with Eof");
+    }
+    window[0] = tokens[tokenIndex++];
+}
+
+// Decodes a NUMBER lexeme in place. Integer literals take the int64 fast
+// path and are exact up to 2^53; the rest are parsed as correctly rounded
+// doubles. Neither path allocates or depends on the locale.
+static double numberLiteral(std::string_view text) {
+    const char* first = text.data();
+    const char* last = first + text.size();
+    if (text.find('.') == std::string_view::npos) {
+        int64_t integer;
+        auto [end, error] = std::from_chars(first, last, integer);
+        if (error == std::errc() && end == last) {
+            return static_cast<double>(integer);
+        }
+    }
+    double number;
+    auto [end, error] = std::from_chars(first, last, number);
+    if (error != std::errc() || end != last) {
+        throw std::runtime_error("Number literal out of range: " + std::string(text));
+    }
+    return number;
+}
 
 bool Parser::atEnd() {
-    return current >= tokens.size() || peek().type == TokenType::Eof;
+    return peek().type == TokenType::Eof;
 }
 
-Token Parser::peek() {
-    return tokens[current];
+const Token& Parser::peek() {
+    return window[current % LOOKAHEAD];
 }
 
-Token Parser::advance() {
+const Token& Parser::advance() {
     if (!atEnd()) {
         current++;
+        window[current % LOOKAHEAD] = tokens != nullptr ? tokens[tokenIndex++] : lexer->nextToken();
     }
     return previous();
 }
 
-Token Parser::previous() {
-    return tokens[current - 1];
+const Token& Parser::previous() {
+    return window[(current - 1) % LOOKAHEAD];
 }
 
 void Parser::consume(TokenType type, const std::string& err) {
@@ -49,131 +88,190 @@ bool Parser::check(TokenType type) {
 }
 
 bool Parser::match(TokenType type) {
-    if (current < tokens.size() && check(type)) {
+    if (check(type)) {
         advance();
         return true;
     }
     return false;
 }
 
-std::vector<std::unique_ptr<Stmt>> Parser::parse() {
-    std::vector<std::unique_ptr<Stmt>> statements;
+std::vector<Stmt*> Parser::parse() {
+    std::vector<Stmt*> statements;
     while (!atEnd()) {
-        statements.push_back(statement());
+        statements.push_back(declaration());
     }
     return statements;
 }
 
-std::unique_ptr<Stmt> Parser::statement() {
-    if (match(TokenType::Print)) return printStatement();
-    if (match(TokenType::If)) return IfStatement();
-    if (match(TokenType::LeftBrace)) return blockStmt();
-    return expressionStatement();
+Stmt* Parser::declaration() {
+    if (match(TokenType::Var)) return varDeclaration();
+    return statement();
+}
+
+Stmt* Parser::varDeclaration() {
+    consume(TokenType::Identifier, "Expect variable name.");
+    Token name = previous();
+    Expr* initializer = nullptr;
+    if (match(TokenType::Equal)) {
+        initializer = expr();
+    }
+    consume(TokenType::Semicolon, "Expect ';' after variable declaration.");
+    auto stmt = arena.make<VarStmt>(name, initializer);
+    stmt->setLine(name.line);
+    return stmt;
+}
+
+Stmt* Parser::statement() {
+    uint32_t line = peek().line;
+    Stmt* stmt;
+    if (match(TokenType::Print)) stmt = printStatement();
+    else if (match(TokenType::If)) stmt = IfStatement();
+    else if (match(TokenType::LeftBrace)) stmt = blockStmt();
+    else stmt = expressionStatement();
+    stmt->setLine(line);
+    return stmt;
 }
 
-std::unique_ptr<Stmt> Parser::blockStmt() {
-    std::vector<std::unique_ptr<Stmt>> statements;
+Stmt* Parser::blockStmt() {
+    std::vector<Stmt*> statements;
     while (!check(TokenType::RightBrace)){
-        statements.push_back(statement());
+        statements.push_back(declaration());
     }
     consume(TokenType::RightBrace, "Expect '}' after block.");
-    return std::make_unique<BlockStmt>(std::move(statements));
+    return arena.make<BlockStmt>(arena.copy(statements));
 }
 
-std::unique_ptr<Stmt> Parser::printStatement() {
-    std::unique_ptr<Expr> value = expr();
+Stmt* Parser::printStatement() {
+    Expr* value = expr();
     consume(TokenType::Semicolon, "Expect ';' after value.'");
-    return std::make_unique<PrintStmt>(std::move(value));
+    return arena.make<PrintStmt>(value);
 }
 
-std::unique_ptr<Stmt> Parser::IfStatement() {
-    std::unique_ptr<Expr> cond = expr();
-    std::unique_ptr<Stmt> then = statement();
+Stmt* Parser::IfStatement() {
+    Expr* cond = expr();
+    Stmt* then = statement();
     if (match(TokenType::Else)) {
-        std::unique_ptr<Stmt> otherwise = statement();
-        return std::make_unique<IfStmt>(std::move(cond), std::move(then), std::move(otherwise));
+        Stmt* otherwise = statement();
+        return arena.make<IfStmt>(cond, then, otherwise);
     } else {
-        return std::make_unique<IfStmt>(std::move(cond), std::move(then));
+        return arena.make<IfStmt>(cond, then);
     }
 }
 
-std::unique_ptr<Stmt> Parser::expressionStatement() {
-    std::unique_ptr<Expr> expression = expr();
+Stmt* Parser::expressionStatement() {
+    Expr* expression = expr();
     consume(TokenType::Semicolon, "Expect ';' afer expression");
-    return std::make_unique<ExpressionStmt>(std::move(expression));
+    return arena.make<ExpressionStmt>(expression);
+}
+
+Expr* Parser::expr() {
+    return assignment();
 }
 
-std::unique_ptr<Expr> Parser::expr() {
-    return equality();
+Expr* Parser::assignment() {
+    Expr* target = equality();
+    if (match(TokenType::Equal)) {
+        Expr* value = assignment();
+        if (auto variable = dynamic_cast<VariableExpr*>(target)) {
+            return arena.make<AssignExpr>(variable->getName(), value);
+        }
+        throw std::runtime_error("Invalid assignment target.");
+    }
+    return target;
 }
 
-std::unique_ptr<Expr> Parser::equality() {
+Expr* Parser::equality() {
     auto left = comparison();
     while (match(TokenType::BangEqual) || match(TokenType::EqualEqual)) {
         auto op = previous();
         auto right = comparison();
-        left = std::make_unique<BinaryExpr>(std::move(left), op, std::move(right));
+        left = arena.make<BinaryExpr>(left, op, right);
     }
     return left;
 }
 
-std::unique_ptr<Expr> Parser::comparison() {
+Expr* Parser::comparison() {
     auto left = term();
     while (match(TokenType::Greater) || match(TokenType::GreaterEqual) || match(TokenType::Less) || match(TokenType::LessEqual)) {
         auto op = previous();
         auto right = term();
-        left = std::make_unique<BinaryExpr>(std::move(left), op, std::move(right));
+        left = arena.make<BinaryExpr>(left, op, right);
     }
     return left;
 }
 
-std::unique_ptr<Expr> Parser::term() {
-    std::unique_ptr<Expr> left = factor();
+Expr* Parser::term() {
+    Expr* left = factor();
     while (match(TokenType::Plus) || match(TokenType::Minus)) {
         Token op = previous();
-        std::unique_ptr<Expr> right = factor();
-        left = std::make_unique<BinaryExpr>(std::move(left), op, std::move(right));
+        Expr* right = factor();
+        left = arena.make<BinaryExpr>(left, op, right);
     }
     return left;
 }
 
-std::unique_ptr<Expr> Parser::factor() {
-    std::unique_ptr<Expr> left = unary();
+Expr* Parser::factor() {
+    Expr* left = unary();
     while (match(TokenType::Star) || match(TokenType::Slash)) {
         Token op = previous();
-        std::unique_ptr<Expr> right = unary();
-        left = std::make_unique<BinaryExpr>(std::move(left), op, std::move(right));
+        Expr* right = unary();
+        left = arena.make<BinaryExpr>(left, op, right);
     }
     return left;
 }
 
-std::unique_ptr<Expr> Parser::unary() {
+Expr* Parser::unary() {
     if (match(TokenType::Plus) || match(TokenType::Minus)) {
         Token op = previous();
-        std::unique_ptr<Expr> expr = unary();
-        return std::make_unique<UnaryExpr>(op, std::move(expr));
+        Expr* expr = unary();
+        return arena.make<UnaryExpr>(op, expr);
     }
     if (match(TokenType::LeftParen)) {
-        std::unique_ptr<Expr> exp = expr();
+        Expr* exp = expr();
         consume(TokenType::RightParen, "Expected ')'");
         return exp;
     }
-    return primary();
+    return call();
+}
+
+Expr* Parser::call() {
+    Expr* callee = primary();
+    if (!match(TokenType::LeftParen)) {
+        return callee;
+    }
+    auto variable = dynamic_cast<VariableExpr*>(callee);
+    if (variable == nullptr) {
+        throw std::runtime_error("Can only call functions by name.");
+    }
+    std::vector<Expr*> arguments;
+    if (!check(TokenType::RightParen)) {
+        do {
+            arguments.push_back(expr());
+        } while (match(TokenType::Comma));
+    }
+    consume(TokenType::RightParen, "Expect ')' after arguments.");
+    return arena.make<CallExpr>(variable->getName(), arena.copy(arguments));
 }
 
-std::unique_ptr<Expr> Parser::primary() {
-    if (match(TokenType::False)) return std::make_unique<LiteralExpr>(false);
-    if (match(TokenType::True)) return std::make_unique<LiteralExpr>(true);
+Expr* Parser::primary() {
+    if (match(TokenType::False)) return arena.make<LiteralExpr>(Value::boolean(false));
+    if (match(TokenType::True)) return arena.make<LiteralExpr>(Value::boolean(true));
 
-    if (match(TokenType::Number) || match(TokenType::String)) {
-        return std::make_unique<LiteralExpr>(previous().literal);
+    if (match(TokenType::Number)) {
+        return arena.make<LiteralExpr>(Value::number(numberLiteral(previous().lexeme)));
+    }
+    if (match(TokenType::String)) {
+        return arena.make<LiteralExpr>(Value::string(previous().lexeme));
+    }
+    if (match(TokenType::Identifier)) {
+        return arena.make<VariableExpr>(previous());
     }
     if (match(TokenType::LeftParen)) {
-        std::unique_ptr<Expr> exp = expr();
+        Expr* exp = expr();
         match(TokenType::RightParen);
         return exp;
     }
-    throw std::runtime_error("Parsing Error - Unexpected token: " + peek().lexeme);
+    throw std::runtime_error("Parsing Error - Unexpected token: " + std::string(peek().lexeme));
 }
 
 
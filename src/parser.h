@@ -3,40 +3,56 @@
 #include <memory>
 #include <vector>
 #include "token.h"
+#include "lexer.h"
 #include <iostream>
 #include "expr.h"
+#include "arena.h"
 
 class Parser {
     public:
-        Parser(const std::vector<Token>& tokens)
-        : tokens{tokens} {}
+        // Tokens are pulled from the lexer on demand; only the current and
+        // previous token are kept, in a small ring buffer.
+        Parser(Lexer& lexer, AstArena& arena);
+        // Reads an already lexed stream, e.g. from lexParallel. It must end
+        // with an Eof token and outlive the parser.
+        Parser(const std::vector<Token>& tokens, AstArena& arena);
 
-        std::vector<std::unique_ptr<Stmt>> parse();
+        std::vector<Stmt*> parse();
 
     private:
         bool atEnd();
-        Token peek();
-        Token advance();
-        Token previous();
+        const Token& peek();
+        const Token& advance();
+        const Token& previous();
         bool eat(TokenType type);
         void consume(TokenType type, const std::string& err);
         bool check(TokenType type);
         bool match(TokenType type);
 
-        std::unique_ptr<Stmt> statement();
-        std::unique_ptr<Stmt> blockStmt();
-        std::unique_ptr<Stmt> expressionStatement();
-        std::unique_ptr<Stmt> printStatement();
-        std::unique_ptr<Stmt> IfStatement();
-        std::unique_ptr<Expr> expr();
-        std::unique_ptr<Expr> equality();
-        std::unique_ptr<Expr> comparison();
-        std::unique_ptr<Expr> term();
-        std::unique_ptr<Expr> factor();
-        std::unique_ptr<Expr> unary();
-        std::unique_ptr<Expr> primary(); 
+        Stmt* declaration();
+        Stmt* varDeclaration();
+        Stmt* statement();
+        Stmt* blockStmt();
+        Stmt* expressionStatement();
+        Stmt* printStatement();
+        Stmt* IfStatement();
+        Expr* expr();
+        Expr* assignment();
+        Expr* equality();
+        Expr* comparison();
+        Expr* term();
+        Expr* factor();
+        Expr* unary();
+        Expr* call();
+        Expr* primary(); 
 
     private:
-        std::vector<Token> tokens;
+        static constexpr size_t LOOKAHEAD = 4;
+
+        Lexer* lexer = nullptr;
+        const Token* tokens = nullptr;
+        size_t tokenIndex = 0;
+        AstArena& arena;
+        Token window[LOOKAHEAD];
         size_t current = 0;
 };
@@ -0,0 +1,101 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <vector>
+
+void Profiler::start() {
+    if (running.exchange(true)) {
+        return;
+    }
+    sampler = std::thread([this] {
+        auto next = std::chrono::steady_clock::now();
+        while (running.load(std::memory_order_relaxed)) {
+            next += interval;
+            std::this_thread::sleep_until(next);
+            sample();
+        }
+    });
+}
+
+void Profiler::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    sampler.join();
+}
+
+void Profiler::sample() {
+    uint32_t top = std::min(depth.load(std::memory_order_acquire), MAX_DEPTH);
+    if (top == 0) {
+        return;
+    }
+    std::string key(top * sizeof(uint32_t), '\0');
+    for (uint32_t i = 0; i < top; i++) {
+        uint32_t line = lines[i].load(std::memory_order_relaxed);
+        std::memcpy(&key[i * sizeof(uint32_t)], &line, sizeof(line));
+    }
+    stacks[key]++;
+    samples++;
+}
+
+static uint32_t frameAt(const std::string& key, size_t index) {
+    uint32_t line;
+    std::memcpy(&line, key.data() + index * sizeof(uint32_t), sizeof(line));
+    return line;
+}
+
+void Profiler::writeFlat(std::ostream& out) const {
+    struct LineSamples {
+        uint64_t self = 0;
+        uint64_t total = 0;
+    };
+    std::map<uint32_t, LineSamples> byLine;
+    for (const auto& [key, count]: stacks) {
+        size_t frames = key.size() / sizeof(uint32_t);
+        byLine[frameAt(key, frames - 1)].self += count;
+        // A line that appears more than once in a stack is counted once.
+        std::vector<uint32_t> seen;
+        for (size_t i = 0; i < frames; i++) {
+            uint32_t line = frameAt(key, i);
+            if (std::find(seen.begin(), seen.end(), line) == seen.end()) {
+                seen.push_back(line);
+                byLine[line].total += count;
+            }
+        }
+    }
+
+    std::vector<std::pair<uint32_t, LineSamples>> rows(byLine.begin(), byLine.end());
+    std::stable_sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+        return a.second.self > b.second.self;
+    });
+
+    double scale = samples != 0 ? 100.0 / static_cast<double>(samples) : 0;
+    out << samples << " samples\n";
+    out << std::right << std::setw(8) << "self" << std::setw(8) << "self%"
+        << std::setw(8) << "total" << std::setw(8) << "total%" << "  line\n";
+    for (const auto& [line, counts]: rows) {
+        out << std::setw(8) << counts.self
+            << std::setw(7) << std::fixed << std::setprecision(1) << counts.self * scale << "%"
+            << std::setw(8) << counts.total
+            << std::setw(7) << counts.total * scale << "%"
+            << "  " << script << ":" << line << "\n";
+    }
+}
+
+void Profiler::writeFolded(std::ostream& out) const {
+    std::vector<std::pair<std::string, uint64_t>> rows(stacks.begin(), stacks.end());
+    std::sort(rows.begin(), rows.end());
+    for (const auto& [key, count]: rows) {
+        // An if and the block it runs usually share a line; show that once.
+        size_t frames = key.size() / sizeof(uint32_t);
+        for (size_t i = 0; i < frames; i++) {
+            if (i > 0 && frameAt(key, i) == frameAt(key, i - 1)) {
+                continue;
+            }
+            out << (i ? ";" : "") << script << ":" << frameAt(key, i);
+        }
+        out << " " << count << "\n";
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Sampling profiler for the tree interpreter. The interpreter pushes the line
+// of each statement it enters onto a shadow stack; a background thread reads
+// that stack on a fixed interval and counts how often each nesting of lines
+// was seen. The script never blocks on the sampler: every slot is an atomic
+// and a sample that races with a push or pop is at worst off by one frame.
+class Profiler {
+    public:
+        Profiler(std::string script, std::chrono::microseconds interval = std::chrono::microseconds{1000})
+        : script{std::move(script)}, interval{interval} {}
+        ~Profiler() { stop(); }
+
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        void start();
+        void stop();
+
+        void enter(uint32_t line) {
+            uint32_t top = depth.load(std::memory_order_relaxed);
+            if (top < MAX_DEPTH) {
+                lines[top].store(line, std::memory_order_relaxed);
+            }
+            depth.store(top + 1, std::memory_order_release);
+        }
+
+        void leave() {
+            depth.store(depth.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+        }
+
+        // Lines by samples spent on the line itself and anywhere beneath it.
+        void writeFlat(std::ostream& out) const;
+        // One "frame;frame;frame count" line per distinct stack, the input
+        // format of flamegraph.pl and speedscope.
+        void writeFolded(std::ostream& out) const;
+
+        uint64_t sampleCount() const { return samples; }
+
+    private:
+        static constexpr uint32_t MAX_DEPTH = 256;
+
+        void sample();
+
+        std::string script;
+        std::chrono::microseconds interval;
+
+        std::atomic<uint32_t> lines[MAX_DEPTH] = {};
+        std::atomic<uint32_t> depth{0};
+
+        std::thread sampler;
+        std::atomic<bool> running{false};
+
+        // Only touched by the sampler thread until stop() joins it. Keys are
+        // stacks of lines, outermost first, each as 4 raw bytes.
+        std::unordered_map<std::string, uint64_t> stacks;
+        uint64_t samples = 0;
+};
+
+// Keeps the profiler's shadow stack balanced when a statement throws.
+class ProfileScope {
+    public:
+        ProfileScope(Profiler& profiler, uint32_t line) : profiler{profiler} { profiler.enter(line); }
+        ~ProfileScope() { profiler.leave(); }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        Profiler& profiler;
+};
@@ -0,0 +1,52 @@
+#include "program.h"
+#include "closure.h"
+#include "compiler.h"
+#include "lexer.h"
+#include "optimizer.h"
+#include "parser.h"
+
+void buildProgram(Program& program, std::string_view code, Resolver& resolver, simplelang::Backend backend,
+                  unsigned lexThreads, Stats* stats) {
+    if (lexThreads > 1 || stats != nullptr) {
+        std::vector<Token> tokens;
+        {
+            PhaseTimer timer{stats, "lex"};
+            tokens = lexParallel(code, lexThreads);
+        }
+        PhaseTimer timer{stats, "parse"};
+        Parser parser{tokens, program.arena};
+        program.statements = parser.parse();
+        if (stats != nullptr) {
+            stats->tokens += tokens.size() - 1;
+        }
+    } else {
+        Lexer lexer{code};
+        Parser parser{lexer, program.arena};
+        program.statements = parser.parse();
+    }
+    if (stats != nullptr) {
+        stats->countNodes(program.statements);
+    }
+    {
+        PhaseTimer timer{stats, "resolve"};
+        program.slots = resolver.resolve(program.statements);
+    }
+    {
+        PhaseTimer timer{stats, "fold"};
+        ConstantFolder folder{program.arena};
+        folder.fold(program.statements);
+    }
+    lowerProgram(program, backend, stats);
+}
+
+void lowerProgram(Program& program, simplelang::Backend backend, Stats* stats) {
+    if (backend == simplelang::Backend::Bytecode) {
+        PhaseTimer timer{stats, "compile"};
+        Compiler compiler;
+        program.chunk = compiler.compile(program.statements, program.slots);
+    } else if (backend == simplelang::Backend::Closure) {
+        PhaseTimer timer{stats, "compile"};
+        ClosureCompiler compiler{program.closures};
+        compiler.compile(program.statements, program.slots);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+#include "chunk.h"
+#include "closure.h"
+#include "expr.h"
+#include "resolver.h"
+#include "simplelang.h"
+#include "source.h"
+#include "stats.h"
+
+// One compilation unit after the front end: the resolved and folded AST in
+// its arena, the frame size it needs and, when targeting the VM or the
+// closure backend, its bytecode or closures. Tokens and names in the AST
+// point into `source` (or `image` for a program loaded from a compiled file)
+// when the program owns its text, otherwise into a buffer the caller keeps
+// alive.
+struct Program {
+    std::string source;
+    SourceFile image;
+    AstArena arena;
+    std::vector<Stmt*> statements;
+    size_t slots = 0;
+    Chunk chunk;
+    ClosureProgram closures;
+};
+
+// Lexes, parses, resolves and folds `code` into `program`, then lowers it for
+// `backend`. With `lexThreads` above 1, large inputs are lexed up front by
+// lexParallel instead of on demand by the parser. With `stats`, every phase
+// is timed separately, which also means lexing up front. Throws
+// std::runtime_error on errors.
+void buildProgram(Program& program, std::string_view code, Resolver& resolver, simplelang::Backend backend,
+                  unsigned lexThreads = 1, Stats* stats = nullptr);
+
+// Fills program.chunk or program.closures from the AST, as `backend` needs.
+// The tree interpreter runs the AST itself.
+void lowerProgram(Program& program, simplelang::Backend backend, Stats* stats = nullptr);
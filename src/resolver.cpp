@@ -0,0 +1,158 @@
+#include "resolver.h"
+#include <stdexcept>
+#include <string>
+
+static std::runtime_error error(const Token& name, const std::string& message) {
+    return std::runtime_error("[line " + std::to_string(name.line) + "] " + message + " '" + std::string(name.lexeme) + "'.");
+}
+
+size_t Resolver::resolve(std::vector<Stmt*>& statements) {
+    size_t globals = locals.size();
+    try {
+        for (Stmt* stmt: statements) {
+            stmt->accept(this);
+        }
+    } catch (std::runtime_error&) {
+        // The program will not run, so forget anything it declared.
+        scopes.clear();
+        popLocals(globals);
+        throw;
+    }
+    return frameSize;
+}
+
+uint32_t Resolver::declareGlobal(std::string_view name) {
+    Token token{TokenType::Identifier, name};
+    uint32_t slot = declare(token);
+    locals[slot].ready = true;
+    return slot;
+}
+
+int64_t& Resolver::binding(const InternedString* name) {
+    if (name->id() >= bindings.size()) {
+        bindings.resize(name->id() + 1, -1);
+    }
+    return bindings[name->id()];
+}
+
+uint32_t Resolver::declare(Token& name) {
+    const InternedString* interned = names.intern(name.lexeme);
+    int64_t& slot = binding(interned);
+    size_t scopeStart = scopes.empty() ? 0 : scopes.back();
+    if (slot >= 0 && static_cast<size_t>(slot) >= scopeStart) {
+        // Redeclaring a global keeps its slot; inside a block it is a mistake.
+        if (scopes.empty()) {
+            return static_cast<uint32_t>(slot);
+        }
+        throw error(name, "Already a variable with this name in this scope");
+    }
+    locals.push_back(Local{interned, false, slot});
+    slot = static_cast<int64_t>(locals.size() - 1);
+    if (locals.size() > frameSize) {
+        frameSize = locals.size();
+    }
+    return static_cast<uint32_t>(slot);
+}
+
+uint32_t Resolver::lookup(Token& name) {
+    int64_t slot = binding(names.intern(name.lexeme));
+    if (slot < 0) {
+        throw error(name, "Undefined variable");
+    }
+    if (!locals[static_cast<size_t>(slot)].ready) {
+        throw error(name, "Can't read a variable in its own initializer");
+    }
+    return static_cast<uint32_t>(slot);
+}
+
+void Resolver::beginScope() {
+    scopes.push_back(locals.size());
+}
+
+void Resolver::endScope() {
+    popLocals(scopes.back());
+    scopes.pop_back();
+}
+
+void Resolver::popLocals(size_t count) {
+    while (locals.size() > count) {
+        bindings[locals.back().name->id()] = locals.back().shadowed;
+        locals.pop_back();
+    }
+}
+
+Value Resolver::visitLiteralExpr(LiteralExpr*) {
+    return Value::nil();
+}
+
+Value Resolver::visitUnaryExpr(UnaryExpr* expr) {
+    expr->getRight()->accept(this);
+    return Value::nil();
+}
+
+Value Resolver::visitBinaryExpr(BinaryExpr* expr) {
+    expr->getLeft()->accept(this);
+    expr->getRight()->accept(this);
+    return Value::nil();
+}
+
+Value Resolver::visitVariableExpr(VariableExpr* expr) {
+    expr->setSlot(lookup(expr->getName()));
+    return Value::nil();
+}
+
+Value Resolver::visitAssignExpr(AssignExpr* expr) {
+    expr->getValue()->accept(this);
+    expr->setSlot(lookup(expr->getName()));
+    return Value::nil();
+}
+
+Value Resolver::visitCallExpr(CallExpr* expr) {
+    for (Expr* argument: expr->getArguments()) {
+        argument->accept(this);
+    }
+    int64_t index = natives != nullptr ? natives->find(expr->getCallee().lexeme) : -1;
+    if (index < 0) {
+        throw error(expr->getCallee(), "Undefined function");
+    }
+    const Native& native = (*natives)[static_cast<uint32_t>(index)];
+    if (native.arity >= 0 && static_cast<size_t>(native.arity) != expr->getArguments().size()) {
+        throw error(expr->getCallee(), "Expected " + std::to_string(native.arity) + " arguments but got " +
+                    std::to_string(expr->getArguments().size()) + " in call to");
+    }
+    expr->setNative(static_cast<uint32_t>(index));
+    return Value::nil();
+}
+
+void Resolver::visitExpressionStmt(ExpressionStmt* stmt) {
+    stmt->getExpression()->accept(this);
+}
+
+void Resolver::visitPrintStmt(PrintStmt* stmt) {
+    stmt->getExpression()->accept(this);
+}
+
+void Resolver::visitVarStmt(VarStmt* stmt) {
+    uint32_t slot = declare(stmt->getName());
+    stmt->setSlot(slot);
+    if (stmt->getInitializer() != nullptr) {
+        stmt->getInitializer()->accept(this);
+    }
+    locals[slot].ready = true;
+}
+
+void Resolver::visitIfStmt(IfStmt* stmt) {
+    stmt->getCondition()->accept(this);
+    stmt->getThen()->accept(this);
+    if (stmt->hasOtherStmt()) {
+        stmt->getOtherwise()->accept(this);
+    }
+}
+
+void Resolver::visitBlockStmt(BlockStmt* stmt) {
+    beginScope();
+    for (Stmt* s: stmt->getStatements()) {
+        s->accept(this);
+    }
+    endScope();
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "expr.h"
+#include "intern.h"
+#include "natives.h"
+
+// Static pass that binds every variable reference to a slot in one flat
+// frame, so the backends index an array instead of looking names up. A
+// block's variables take the slots above its parent's and give them back
+// when the block ends. There are no functions yet, so every reference
+// resolves into the same frame.
+//
+// The resolver keeps its top-level scope between calls. That way a later
+// program, such as the next REPL line, still sees the globals declared by
+// earlier ones.
+//
+// Names are interned in the resolver's own table, and each name's innermost
+// binding is kept in a vector indexed by its intern id. Declaring, looking up
+// and leaving a scope are all O(1) per name, with no string comparisons
+// beyond the intern lookup.
+class Resolver: public ExprVisitor, public StmtVisitor {
+    public:
+        Resolver(const Natives* natives = nullptr) : natives{natives} {}
+
+        // Returns the number of frame slots the program needs.
+        size_t resolve(std::vector<Stmt*>& statements);
+
+        // Declares an initialized global ahead of the program, e.g. a host
+        // supplied input.
+        uint32_t declareGlobal(std::string_view name);
+
+    private:
+        uint32_t declare(Token& name);
+        uint32_t lookup(Token& name);
+        int64_t& binding(const InternedString* name);
+
+        void beginScope();
+        void endScope();
+        // Drops locals above `count`, uncovering whatever they shadowed.
+        void popLocals(size_t count);
+
+        Value visitLiteralExpr(LiteralExpr* expr) override;
+        Value visitUnaryExpr(UnaryExpr* expr) override;
+        Value visitBinaryExpr(BinaryExpr* expr) override;
+        Value visitVariableExpr(VariableExpr* expr) override;
+        Value visitAssignExpr(AssignExpr* expr) override;
+        Value visitCallExpr(CallExpr* expr) override;
+
+        void visitExpressionStmt(ExpressionStmt* stmt) override;
+        void visitPrintStmt(PrintStmt* stmt) override;
+        void visitVarStmt(VarStmt* stmt) override;
+        void visitIfStmt(IfStmt* stmt) override;
+        void visitBlockStmt(BlockStmt* stmt) override;
+
+    private:
+        const Natives* natives;
+
+        struct Local {
+            const InternedString* name;
+            bool ready;
+            // Slot this local hides, or -1.
+            int64_t shadowed;
+        };
+
+        Interner names;
+        // Index in this vector is the variable's slot.
+        std::vector<Local> locals;
+        // Innermost visible slot for each name, by intern id, or -1.
+        std::vector<int64_t> bindings;
+        // Where each open block scope starts in `locals`.
+        std::vector<size_t> scopes;
+        size_t frameSize = 0;
+};
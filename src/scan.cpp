@@ -0,0 +1,244 @@
+#include "scan.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SL_SCAN_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__)
+#define SL_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SL_TARGET_AVX2
+#endif
+
+namespace scan {
+
+static inline uint32_t popcount(uint32_t mask) {
+#ifdef _MSC_VER
+    return __popcnt(mask);
+#else
+    return static_cast<uint32_t>(__builtin_popcount(mask));
+#endif
+}
+
+static inline uint32_t lowestBit(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+}
+
+// Newlines strictly below bit `index`.
+static inline uint32_t newlinesBefore(uint32_t newlines, uint32_t index) {
+    return popcount(newlines & ((1u << index) - 1));
+}
+
+static inline bool isWhitespace(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+static size_t skipWhitespaceScalar(const char* data, size_t size, size_t pos, uint32_t& lines) {
+    while (pos < size && isWhitespace(data[pos])) {
+        if (data[pos] == '\n') {
+            lines++;
+        }
+        pos++;
+    }
+    return pos;
+}
+
+static size_t findNewlineScalar(const char* data, size_t size, size_t pos) {
+    while (pos < size && data[pos] != '\n') {
+        pos++;
+    }
+    return pos;
+}
+
+static size_t findQuoteScalar(const char* data, size_t size, size_t pos, uint32_t& lines) {
+    while (pos < size && data[pos] != '"') {
+        if (data[pos] == '\n') {
+            lines++;
+        }
+        pos++;
+    }
+    return pos;
+}
+
+#ifdef SL_SCAN_X86
+
+static size_t skipWhitespaceSse2(const char* data, size_t size, size_t pos, uint32_t& lines) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    while (pos + 16 <= size) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i newline = _mm_cmpeq_epi8(chunk, lf);
+        __m128i blank = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+                                     _mm_or_si128(_mm_cmpeq_epi8(chunk, cr), newline));
+        uint32_t newlines = static_cast<uint32_t>(_mm_movemask_epi8(newline));
+        uint32_t other = ~static_cast<uint32_t>(_mm_movemask_epi8(blank)) & 0xffff;
+        if (other != 0) {
+            uint32_t index = lowestBit(other);
+            lines += newlinesBefore(newlines, index);
+            return pos + index;
+        }
+        lines += popcount(newlines);
+        pos += 16;
+    }
+    return skipWhitespaceScalar(data, size, pos, lines);
+}
+
+static size_t findNewlineSse2(const char* data, size_t size, size_t pos) {
+    const __m128i lf = _mm_set1_epi8('\n');
+    while (pos + 16 <= size) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        uint32_t newlines = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lf)));
+        if (newlines != 0) {
+            return pos + lowestBit(newlines);
+        }
+        pos += 16;
+    }
+    return findNewlineScalar(data, size, pos);
+}
+
+static size_t findQuoteSse2(const char* data, size_t size, size_t pos, uint32_t& lines) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i lf = _mm_set1_epi8('\n');
+    while (pos + 16 <= size) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        uint32_t quotes = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)));
+        uint32_t newlines = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lf)));
+        if (quotes != 0) {
+            uint32_t index = lowestBit(quotes);
+            lines += newlinesBefore(newlines, index);
+            return pos + index;
+        }
+        lines += popcount(newlines);
+        pos += 16;
+    }
+    return findQuoteScalar(data, size, pos, lines);
+}
+
+SL_TARGET_AVX2 static size_t skipWhitespaceAvx2(const char* data, size_t size, size_t pos, uint32_t& lines) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    while (pos + 32 <= size) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i newline = _mm256_cmpeq_epi8(chunk, lf);
+        __m256i blank = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, space), _mm256_cmpeq_epi8(chunk, tab)),
+                                        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, cr), newline));
+        uint32_t newlines = static_cast<uint32_t>(_mm256_movemask_epi8(newline));
+        uint32_t other = ~static_cast<uint32_t>(_mm256_movemask_epi8(blank));
+        if (other != 0) {
+            uint32_t index = lowestBit(other);
+            lines += newlinesBefore(newlines, index);
+            return pos + index;
+        }
+        lines += popcount(newlines);
+        pos += 32;
+    }
+    return skipWhitespaceSse2(data, size, pos, lines);
+}
+
+SL_TARGET_AVX2 static size_t findNewlineAvx2(const char* data, size_t size, size_t pos) {
+    const __m256i lf = _mm256_set1_epi8('\n');
+    while (pos + 32 <= size) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        uint32_t newlines = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, lf)));
+        if (newlines != 0) {
+            return pos + lowestBit(newlines);
+        }
+        pos += 32;
+    }
+    return findNewlineSse2(data, size, pos);
+}
+
+SL_TARGET_AVX2 static size_t findQuoteAvx2(const char* data, size_t size, size_t pos, uint32_t& lines) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    while (pos + 32 <= size) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        uint32_t quotes = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, quote)));
+        uint32_t newlines = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, lf)));
+        if (quotes != 0) {
+            uint32_t index = lowestBit(quotes);
+            lines += newlinesBefore(newlines, index);
+            return pos + index;
+        }
+        lines += popcount(newlines);
+        pos += 32;
+    }
+    return findQuoteSse2(data, size, pos, lines);
+}
+
+static bool cpuHasAvx2() {
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+#endif
+
+struct Scanners {
+    size_t (*skipWhitespace)(const char*, size_t, size_t, uint32_t&);
+    size_t (*findNewline)(const char*, size_t, size_t);
+    size_t (*findQuote)(const char*, size_t, size_t, uint32_t&);
+    const char* name;
+};
+
+static Scanners select() {
+#ifdef SL_SCAN_X86
+    if (cpuHasAvx2()) {
+        return {skipWhitespaceAvx2, findNewlineAvx2, findQuoteAvx2, "avx2"};
+    }
+    return {skipWhitespaceSse2, findNewlineSse2, findQuoteSse2, "sse2"};
+#else
+    return {skipWhitespaceScalar, findNewlineScalar, findQuoteScalar, "scalar"};
+#endif
+}
+
+static const Scanners active = select();
+
+size_t skipWhitespace(const char* data, size_t size, size_t pos, uint32_t& lines) {
+    return active.skipWhitespace(data, size, pos, lines);
+}
+
+size_t findNewline(const char* data, size_t size, size_t pos) {
+    return active.findNewline(data, size, pos);
+}
+
+size_t findQuote(const char* data, size_t size, size_t pos, uint32_t& lines) {
+    return active.findQuote(data, size, pos, lines);
+}
+
+const char* implementation() {
+    return active.name;
+}
+
+}
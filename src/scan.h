@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Bulk character scanners for the lexer. Each one starts at `pos` and returns
+// the index of the first byte it stops at (or `size`), adding any newlines it
+// stepped over to `lines`. The implementation (AVX2, SSE2 or scalar) is chosen
+// once at startup from the running CPU.
+namespace scan {
+
+// First byte that is not ' ', '\t', '\r' or '\n'.
+size_t skipWhitespace(const char* data, size_t size, size_t pos, uint32_t& lines);
+
+// First '\n'. Nothing is counted since the scan stops on the newline itself.
+size_t findNewline(const char* data, size_t size, size_t pos);
+
+// First '"'.
+size_t findQuote(const char* data, size_t size, size_t pos, uint32_t& lines);
+
+// Name of the selected implementation, for diagnostics.
+const char* implementation();
+
+}
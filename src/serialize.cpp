@@ -0,0 +1,365 @@
+#include "serialize.h"
+#include <cstring>
+#include <stdexcept>
+
+static constexpr char MAGIC[4] = {'S', 'L', 'C', '\0'};
+static constexpr uint32_t VERSION = 3;
+
+enum class NodeTag : uint8_t {
+    Literal, Unary, Binary, Variable, Assign, Call,
+    Expression, Print, Var, If, Block,
+};
+
+enum class LiteralTag : uint8_t {
+    Nil, False, True, Number, String,
+};
+
+bool isCompiledImage(std::string_view bytes) {
+    return bytes.size() >= sizeof(MAGIC) && std::memcmp(bytes.data(), MAGIC, sizeof(MAGIC)) == 0;
+}
+
+class ImageWriter: public ExprVisitor, public StmtVisitor {
+    public:
+        std::string write(Program& program, const ImageInfo& info) {
+            out.append(MAGIC, sizeof(MAGIC));
+            u32(VERSION);
+            u64(info.sourceKey);
+            u64(info.source.size());
+            out.append(info.source);
+            u32(static_cast<uint32_t>(program.slots));
+            u32(static_cast<uint32_t>(info.inputs.size()));
+            for (const std::string& name: info.inputs) {
+                string(name);
+            }
+            u32(static_cast<uint32_t>(program.statements.size()));
+            for (Stmt* stmt: program.statements) {
+                stmt->accept(this);
+            }
+            return std::move(out);
+        }
+
+    private:
+        void u8(uint8_t value) { out.push_back(static_cast<char>(value)); }
+        void u32(uint32_t value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+        void u64(uint64_t value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+        void tag(NodeTag t) { u8(static_cast<uint8_t>(t)); }
+        void tag(NodeTag t, Stmt* stmt) {
+            tag(t);
+            u32(stmt->getLine());
+        }
+        void string(std::string_view text) {
+            u32(static_cast<uint32_t>(text.size()));
+            out.append(text);
+        }
+
+        Value visitLiteralExpr(LiteralExpr* expr) override {
+            tag(NodeTag::Literal);
+            Value value = expr->getValue();
+            if (value.isNumber()) {
+                u8(static_cast<uint8_t>(LiteralTag::Number));
+                double number = value.asNumber();
+                uint64_t bits;
+                std::memcpy(&bits, &number, sizeof(bits));
+                u64(bits);
+            } else if (value.isString()) {
+                u8(static_cast<uint8_t>(LiteralTag::String));
+                string(value.asString());
+            } else if (value.isBool()) {
+                u8(static_cast<uint8_t>(value.asBool() ? LiteralTag::True : LiteralTag::False));
+            } else {
+                u8(static_cast<uint8_t>(LiteralTag::Nil));
+            }
+            return Value::nil();
+        }
+
+        Value visitUnaryExpr(UnaryExpr* expr) override {
+            tag(NodeTag::Unary);
+            u8(static_cast<uint8_t>(expr->getOp().type));
+            expr->getRight()->accept(this);
+            return Value::nil();
+        }
+
+        Value visitBinaryExpr(BinaryExpr* expr) override {
+            tag(NodeTag::Binary);
+            u8(static_cast<uint8_t>(expr->getOp().type));
+            expr->getLeft()->accept(this);
+            expr->getRight()->accept(this);
+            return Value::nil();
+        }
+
+        Value visitVariableExpr(VariableExpr* expr) override {
+            tag(NodeTag::Variable);
+            u32(expr->getSlot());
+            string(expr->getName().lexeme);
+            return Value::nil();
+        }
+
+        Value visitAssignExpr(AssignExpr* expr) override {
+            tag(NodeTag::Assign);
+            u32(expr->getSlot());
+            string(expr->getName().lexeme);
+            expr->getValue()->accept(this);
+            return Value::nil();
+        }
+
+        Value visitCallExpr(CallExpr* expr) override {
+            tag(NodeTag::Call);
+            string(expr->getCallee().lexeme);
+            u32(static_cast<uint32_t>(expr->getArguments().size()));
+            for (Expr* argument: expr->getArguments()) {
+                argument->accept(this);
+            }
+            return Value::nil();
+        }
+
+        void visitExpressionStmt(ExpressionStmt* stmt) override {
+            tag(NodeTag::Expression, stmt);
+            stmt->getExpression()->accept(this);
+        }
+
+        void visitPrintStmt(PrintStmt* stmt) override {
+            tag(NodeTag::Print, stmt);
+            stmt->getExpression()->accept(this);
+        }
+
+        void visitVarStmt(VarStmt* stmt) override {
+            tag(NodeTag::Var, stmt);
+            u32(stmt->getSlot());
+            string(stmt->getName().lexeme);
+            u8(stmt->getInitializer() != nullptr);
+            if (stmt->getInitializer() != nullptr) {
+                stmt->getInitializer()->accept(this);
+            }
+        }
+
+        void visitIfStmt(IfStmt* stmt) override {
+            tag(NodeTag::If, stmt);
+            u8(stmt->hasOtherStmt());
+            stmt->getCondition()->accept(this);
+            stmt->getThen()->accept(this);
+            if (stmt->hasOtherStmt()) {
+                stmt->getOtherwise()->accept(this);
+            }
+        }
+
+        void visitBlockStmt(BlockStmt* stmt) override {
+            tag(NodeTag::Block, stmt);
+            u32(static_cast<uint32_t>(stmt->getStatements().size()));
+            for (Stmt* s: stmt->getStatements()) {
+                s->accept(this);
+            }
+        }
+
+    private:
+        std::string out;
+};
+
+class ImageReader {
+    public:
+        ImageReader(Program& program, std::string_view image, const Natives* natives)
+        : program{program}, arena{program.arena}, image{image}, natives{natives} {}
+
+        ImageInfo read() {
+            if (!isCompiledImage(image)) {
+                corrupt();
+            }
+            pos = sizeof(MAGIC);
+            if (u32() != VERSION) {
+                throw std::runtime_error("Compiled script was written by an incompatible version");
+            }
+            ImageInfo info;
+            info.sourceKey = u64();
+            uint64_t sourceSize = u64();
+            if (sourceSize > image.size()) {
+                corrupt();
+            }
+            info.source = std::string_view(take(static_cast<size_t>(sourceSize)), static_cast<size_t>(sourceSize));
+            slots = u32();
+            uint32_t inputs = u32();
+            for (uint32_t i = 0; i < inputs; i++) {
+                info.inputs.emplace_back(string());
+            }
+            uint32_t count = u32();
+            program.statements.clear();
+            for (uint32_t i = 0; i < count; i++) {
+                program.statements.push_back(stmt());
+            }
+            if (pos != image.size()) {
+                corrupt();
+            }
+            program.slots = slots;
+            return info;
+        }
+
+    private:
+        [[noreturn]] void corrupt() {
+            throw std::runtime_error("Corrupt compiled script");
+        }
+
+        const char* take(size_t size) {
+            if (image.size() - pos < size) {
+                corrupt();
+            }
+            const char* data = image.data() + pos;
+            pos += size;
+            return data;
+        }
+
+        uint8_t u8() { return static_cast<uint8_t>(*take(1)); }
+        uint32_t u32() {
+            uint32_t value;
+            std::memcpy(&value, take(sizeof(value)), sizeof(value));
+            return value;
+        }
+        uint64_t u64() {
+            uint64_t value;
+            std::memcpy(&value, take(sizeof(value)), sizeof(value));
+            return value;
+        }
+        std::string_view string() {
+            uint32_t size = u32();
+            return std::string_view(take(size), size);
+        }
+        uint32_t slot() {
+            uint32_t s = u32();
+            if (s >= slots) {
+                corrupt();
+            }
+            return s;
+        }
+        Token op() {
+            uint8_t type = u8();
+            if (type >= TokenType::Unknown) {
+                corrupt();
+            }
+            return Token(static_cast<TokenType>(type), "");
+        }
+        Token name() {
+            return Token(TokenType::Identifier, string());
+        }
+
+        Expr* expr() {
+            switch (static_cast<NodeTag>(u8())) {
+                case NodeTag::Literal: return literal();
+                case NodeTag::Unary: {
+                    Token o = op();
+                    return arena.make<UnaryExpr>(o, expr());
+                } break;
+                case NodeTag::Binary: {
+                    Token o = op();
+                    Expr* left = expr();
+                    return arena.make<BinaryExpr>(left, o, expr());
+                } break;
+                case NodeTag::Variable: {
+                    uint32_t s = slot();
+                    auto variable = arena.make<VariableExpr>(name());
+                    variable->setSlot(s);
+                    return variable;
+                } break;
+                case NodeTag::Assign: {
+                    uint32_t s = slot();
+                    Token n = name();
+                    auto assign = arena.make<AssignExpr>(n, expr());
+                    assign->setSlot(s);
+                    return assign;
+                } break;
+                case NodeTag::Call: return call();
+                default: corrupt();
+            }
+        }
+
+        Expr* literal() {
+            switch (static_cast<LiteralTag>(u8())) {
+                case LiteralTag::Nil: return arena.make<LiteralExpr>(Value::nil());
+                case LiteralTag::False: return arena.make<LiteralExpr>(Value::boolean(false));
+                case LiteralTag::True: return arena.make<LiteralExpr>(Value::boolean(true));
+                case LiteralTag::Number: {
+                    uint64_t bits = u64();
+                    double number;
+                    std::memcpy(&number, &bits, sizeof(number));
+                    return arena.make<LiteralExpr>(Value::number(number));
+                } break;
+                case LiteralTag::String: return arena.make<LiteralExpr>(Value::string(string()));
+                default: corrupt();
+            }
+        }
+
+        Expr* call() {
+            Token callee = name();
+            int64_t index = natives != nullptr ? natives->find(callee.lexeme) : -1;
+            if (index < 0) {
+                throw std::runtime_error("Compiled script calls unknown function '" + std::string(callee.lexeme) + "'");
+            }
+            uint32_t count = u32();
+            const Native& native = (*natives)[static_cast<uint32_t>(index)];
+            if (native.arity >= 0 && static_cast<uint32_t>(native.arity) != count) {
+                throw std::runtime_error("Compiled script calls '" + std::string(callee.lexeme) + "' with the wrong number of arguments");
+            }
+            std::vector<Expr*> arguments;
+            for (uint32_t i = 0; i < count; i++) {
+                arguments.push_back(expr());
+            }
+            auto node = arena.make<CallExpr>(callee, arena.copy(arguments));
+            node->setNative(static_cast<uint32_t>(index));
+            return node;
+        }
+
+        Stmt* stmt() {
+            auto tag = static_cast<NodeTag>(u8());
+            uint32_t line = u32();
+            Stmt* s = statementBody(tag);
+            s->setLine(line);
+            return s;
+        }
+
+        Stmt* statementBody(NodeTag tag) {
+            switch (tag) {
+                case NodeTag::Expression: return arena.make<ExpressionStmt>(expr());
+                case NodeTag::Print: return arena.make<PrintStmt>(expr());
+                case NodeTag::Var: {
+                    uint32_t s = slot();
+                    Token n = name();
+                    Expr* initializer = u8() ? expr() : nullptr;
+                    auto var = arena.make<VarStmt>(n, initializer);
+                    var->setSlot(s);
+                    return var;
+                } break;
+                case NodeTag::If: {
+                    bool hasOther = u8() != 0;
+                    Expr* cond = expr();
+                    Stmt* then = stmt();
+                    if (hasOther) {
+                        return arena.make<IfStmt>(cond, then, stmt());
+                    }
+                    return arena.make<IfStmt>(cond, then);
+                } break;
+                case NodeTag::Block: {
+                    uint32_t count = u32();
+                    std::vector<Stmt*> statements;
+                    for (uint32_t i = 0; i < count; i++) {
+                        statements.push_back(stmt());
+                    }
+                    return arena.make<BlockStmt>(arena.copy(statements));
+                } break;
+                default: corrupt();
+            }
+        }
+
+    private:
+        Program& program;
+        AstArena& arena;
+        std::string_view image;
+        const Natives* natives;
+        size_t pos = 0;
+        uint32_t slots = 0;
+};
+
+std::string writeImage(Program& program, const ImageInfo& info) {
+    ImageWriter writer;
+    return writer.write(program, info);
+}
+
+ImageInfo loadImage(Program& program, std::string_view image, const Natives* natives) {
+    ImageReader reader{program, image, natives};
+    return reader.read();
+}
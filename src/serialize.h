@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "natives.h"
+#include "program.h"
+
+// Compiled script image: a resolved, folded AST written out so it can be
+// loaded and run without the lexer, parser or resolver. Little-endian:
+//
+//   "SLC\0"  magic
+//   u32      format version
+//   u64      key of the source it was compiled from (scriptKey)
+//   u64      source size in bytes, then the source text itself
+//   u32      frame slots
+//   u32      input count, then each input name as a string
+//   u32      statement count, then each statement in preorder
+//
+// Every statement starts with its tag byte and u32 source line. A string is
+// a u32 length followed by its bytes. Names in a loaded AST point
+// straight into the image, so the image must outlive the program.
+//
+// The key only finds an image quickly; the stored text is what a cache
+// compares before trusting one.
+struct ImageInfo {
+    uint64_t sourceKey = 0;
+    // Points into the image once loaded.
+    std::string_view source;
+    std::vector<std::string> inputs;
+};
+
+bool isCompiledImage(std::string_view bytes);
+
+std::string writeImage(Program& program, const ImageInfo& info);
+
+// Rebuilds `program` from `image`, binding calls against `natives` by name.
+// Throws std::runtime_error if the image is malformed or from another
+// format version.
+ImageInfo loadImage(Program& program, std::string_view image, const Natives* natives);
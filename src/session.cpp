@@ -0,0 +1,47 @@
+#include "session.h"
+#include "output.h"
+#include "program.h"
+#include "serialize.h"
+
+void Session::eval(std::string code) {
+    sources.push_back(std::move(code));
+    run(sources.back());
+}
+
+void Session::run(std::string_view code) {
+    try {
+        Program program;
+        if (isCompiledImage(code)) {
+            {
+                PhaseTimer timer{stats, "load"};
+                loadImage(program, code, nullptr);
+            }
+            if (stats != nullptr) {
+                stats->countNodes(program.statements);
+            }
+            lowerProgram(program, backend, stats);
+        } else {
+            buildProgram(program, code, resolver, backend, lexThreads, stats);
+        }
+        PhaseTimer timer{stats, "execute"};
+        if (backend == simplelang::Backend::Bytecode) {
+            vm.run(program.chunk);
+        } else if (backend == simplelang::Backend::Closure) {
+            closures.run(program.closures);
+        } else {
+            uint64_t statements = interpreter.statementsExecuted();
+            uint64_t expressions = interpreter.expressionsEvaluated();
+            interpreter.interpret(program.statements, program.slots);
+            if (stats != nullptr) {
+                statements = interpreter.statementsExecuted() - statements;
+                stats->statements += statements;
+                stats->dispatches += statements + interpreter.expressionsEvaluated() - expressions;
+            }
+        }
+    } catch (std::exception& e) {
+        OutputSink& out = standardOutput();
+        out.write(e.what());
+        out.write("\n");
+        out.flush();
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include "closure.h"
+#include "interpreter.h"
+#include "resolver.h"
+#include "simplelang.h"
+#include "stats.h"
+#include "vm.h"
+
+// Evaluation state that lives across inputs. The resolver's globals, the
+// backend's variable frame, and the source text that global names point
+// into all survive from one input to the next, so each REPL line only
+// lexes, parses and compiles its own text.
+class Session {
+    public:
+        // `profiler` only applies to the tree interpreter.
+        Session(simplelang::Backend backend, unsigned lexThreads = 1, Stats* stats = nullptr,
+                Profiler* profiler = nullptr)
+        : backend{backend}, lexThreads{lexThreads}, stats{stats} {
+            interpreter.setProfiler(profiler);
+        }
+
+        // Takes ownership of `code` so names declared in it stay valid.
+        void eval(std::string code);
+        // `code` must outlive the session. It may be source text or an
+        // image written by --compile.
+        void run(std::string_view code);
+
+    private:
+        simplelang::Backend backend;
+        unsigned lexThreads;
+        // Filled in by every run() when set.
+        Stats* stats;
+        Resolver resolver;
+        Interpreter interpreter;
+        VM vm;
+        ClosureRunner closures;
+        std::deque<std::string> sources;
+};
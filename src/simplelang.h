@@ -0,0 +1,104 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "natives.h"
+#include "output.h"
+#include "value.h"
+
+struct Program;
+
+namespace simplelang {
+class ScriptCache;
+}
+
+// Embedding API. Typical use:
+//
+//     simplelang::Engine engine;
+//     engine.registerNative("clock", 0, [](const Value*, size_t) { ... });
+//     simplelang::Script script = engine.compile(source, {"x", "y"});
+//     StringSink out;
+//     engine.run(script, {Value::number(1), Value::number(2)}, &out);
+//
+// Errors from either step are thrown as std::runtime_error. Once natives
+// are registered, compile() and run() may be called from any number of
+// threads at once; each run() gets its own interpreter, VM or closure runner.
+//
+// String inputs. Value::string() interns the text for the life of the
+// process, so such a value can be passed to any run on any thread. A string
+// from StringObject::make() is counted instead: the host owns one reference,
+// the value stays valid across runs and compiles until the host calls
+// StringObject::release() on it, and it may only be used on the thread that
+// made it. Strings a script builds never outlive its run().
+namespace simplelang {
+
+// Tree walks the AST with the Interpreter, Bytecode compiles it for the VM
+// and Closure compiles it to a tree of specialized closures (closure.h).
+enum class Backend { Tree, Bytecode, Closure };
+
+// A compiled script. Immutable once compiled and cheap to copy; copies share
+// the same program, so one compile can be run any number of times.
+class Script {
+    public:
+        Script() = default;
+
+        // Names of the host-supplied inputs, in the order run() expects them.
+        const std::vector<std::string>& inputs() const { return inputNames; }
+        bool valid() const { return program != nullptr; }
+
+    private:
+        friend class Engine;
+        friend class ScriptCache;
+
+        std::shared_ptr<Program> program;
+        std::vector<std::string> inputNames;
+};
+
+class Engine {
+    public:
+        explicit Engine(Backend backend = Backend::Tree);
+        ~Engine();
+
+        // Makes `name(args)` callable from scripts compiled after this call.
+        // `arity` of -1 accepts any number of arguments.
+        void registerNative(std::string name, int arity, NativeFunction function);
+
+        // Compiles `source` once. Each name in `inputs` is a global that is
+        // already defined when the script starts; run() supplies its value.
+        // Names must be distinct.
+        // Repeated compiles of the same text are served from the script
+        // cache without touching the lexer or parser.
+        Script compile(std::string_view source, std::vector<std::string> inputs = {});
+
+        // Runs a compiled script with fresh variables. Output goes to `out`,
+        // or to stdout when it is null. The stdout sink is shared and not
+        // synchronized, so concurrent runs must each pass their own sink.
+        void run(const Script& script, const std::vector<Value>& inputs = {}, OutputSink* out = nullptr) const;
+
+        // compile() followed by run().
+        void eval(std::string_view source, const std::vector<std::string>& inputNames = {},
+                  const std::vector<Value>& inputs = {}, OutputSink* out = nullptr);
+
+        // Maximum number of compiled scripts kept; 0 disables caching.
+        void setCacheCapacity(size_t entries);
+        // Also keep compiled scripts as images in `directory`, so they
+        // survive the process. Empty (the default) keeps them in memory only.
+        void setCacheDirectory(std::string directory);
+        const ScriptCache& cache() const { return *scripts; }
+
+    private:
+        std::shared_ptr<Program> loadImageFile(uint64_t key, std::string_view source,
+                                               const std::vector<std::string>& inputs) const;
+        void storeImageFile(uint64_t key, std::string_view source, const std::vector<std::string>& inputs,
+                            Program& program) const;
+        std::string imagePath(uint64_t key) const;
+
+    private:
+        Backend backend;
+        Natives natives;
+        std::unique_ptr<ScriptCache> scripts;
+        std::string cacheDirectory;
+};
+
+}
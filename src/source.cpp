@@ -0,0 +1,111 @@
+#include "source.h"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SourceFile::~SourceFile() {
+    unmap();
+}
+
+bool SourceFile::open(const std::string& path) {
+    unmap();
+    buffer.clear();
+    view = {};
+    if (path != "-" && map(path)) {
+        return true;
+    }
+    return readAll(path);
+}
+
+bool SourceFile::readAll(const std::string& path) {
+    if (path == "-") {
+        buffer.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+    } else {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    view = buffer;
+    return true;
+}
+
+#ifdef _WIN32
+
+bool SourceFile::map(const std::string& path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE section = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (section == nullptr) {
+        return false;
+    }
+    void* data = MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(section);
+    if (data == nullptr) {
+        return false;
+    }
+    mapping = data;
+    mappedSize = static_cast<size_t>(size.QuadPart);
+    view = std::string_view(static_cast<const char*>(mapping), mappedSize);
+    return true;
+}
+
+void SourceFile::unmap() {
+    if (mapping != nullptr) {
+        UnmapViewOfFile(mapping);
+        mapping = nullptr;
+        mappedSize = 0;
+    }
+}
+
+#else
+
+bool SourceFile::map(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+    mapping = data;
+    mappedSize = static_cast<size_t>(info.st_size);
+    view = std::string_view(static_cast<const char*>(mapping), mappedSize);
+    return true;
+}
+
+void SourceFile::unmap() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappedSize);
+        mapping = nullptr;
+        mappedSize = 0;
+    }
+}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only script text. Regular files are memory-mapped and handed to the
+// lexer as a view over the mapping; stdin ("-"), pipes and anything else that
+// cannot be mapped are read into an owned buffer instead.
+class SourceFile {
+    public:
+        SourceFile() = default;
+        ~SourceFile();
+        SourceFile(const SourceFile&) = delete;
+        SourceFile& operator=(const SourceFile&) = delete;
+
+        bool open(const std::string& path);
+        std::string_view text() const { return view; }
+
+    private:
+        bool map(const std::string& path);
+        bool readAll(const std::string& path);
+        void unmap();
+
+    private:
+        void* mapping = nullptr;
+        size_t mappedSize = 0;
+        std::string buffer;
+        std::string_view view;
+};
@@ -0,0 +1,195 @@
+#include "stats.h"
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+#ifdef SIMPLELANG_ALLOC_STATS
+
+// Thread-local, so counting costs two plain increments per allocation and
+// each phase only sees its own thread's allocations.
+static thread_local AllocationCount allocated;
+
+void* operator new(std::size_t size) {
+    allocated.count++;
+    allocated.bytes += size;
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+        if (void* memory = std::malloc(size)) {
+            return memory;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+AllocationCount threadAllocations() {
+    return allocated;
+}
+
+#else
+
+AllocationCount threadAllocations() {
+    return AllocationCount{};
+}
+
+#endif
+
+static const char* const NODE_NAMES[] = {
+    "Literal", "Unary", "Binary", "Variable", "Assign", "Call",
+    "ExpressionStmt", "PrintStmt", "VarStmt", "IfStmt", "BlockStmt",
+};
+
+static_assert(sizeof(NODE_NAMES) / sizeof(NODE_NAMES[0]) == static_cast<size_t>(NodeKind::Count),
+              "every node kind needs a name");
+
+class NodeCounter: public ExprVisitor, public StmtVisitor {
+    public:
+        NodeCounter(uint64_t* nodes) : nodes{nodes} {}
+
+        void count(std::vector<Stmt*>& statements) {
+            for (Stmt* stmt: statements) {
+                stmt->accept(this);
+            }
+        }
+
+    private:
+        void add(NodeKind kind) { nodes[static_cast<size_t>(kind)]++; }
+
+        Value visitLiteralExpr(LiteralExpr*) override {
+            add(NodeKind::Literal);
+            return Value::nil();
+        }
+        Value visitUnaryExpr(UnaryExpr* expr) override {
+            add(NodeKind::Unary);
+            expr->getRight()->accept(this);
+            return Value::nil();
+        }
+        Value visitBinaryExpr(BinaryExpr* expr) override {
+            add(NodeKind::Binary);
+            expr->getLeft()->accept(this);
+            expr->getRight()->accept(this);
+            return Value::nil();
+        }
+        Value visitVariableExpr(VariableExpr*) override {
+            add(NodeKind::Variable);
+            return Value::nil();
+        }
+        Value visitAssignExpr(AssignExpr* expr) override {
+            add(NodeKind::Assign);
+            expr->getValue()->accept(this);
+            return Value::nil();
+        }
+        Value visitCallExpr(CallExpr* expr) override {
+            add(NodeKind::Call);
+            for (Expr* argument: expr->getArguments()) {
+                argument->accept(this);
+            }
+            return Value::nil();
+        }
+
+        void visitExpressionStmt(ExpressionStmt* stmt) override {
+            add(NodeKind::Expression);
+            stmt->getExpression()->accept(this);
+        }
+        void visitPrintStmt(PrintStmt* stmt) override {
+            add(NodeKind::Print);
+            stmt->getExpression()->accept(this);
+        }
+        void visitVarStmt(VarStmt* stmt) override {
+            add(NodeKind::Var);
+            if (stmt->getInitializer() != nullptr) {
+                stmt->getInitializer()->accept(this);
+            }
+        }
+        void visitIfStmt(IfStmt* stmt) override {
+            add(NodeKind::If);
+            stmt->getCondition()->accept(this);
+            stmt->getThen()->accept(this);
+            if (stmt->hasOtherStmt()) {
+                stmt->getOtherwise()->accept(this);
+            }
+        }
+        void visitBlockStmt(BlockStmt* stmt) override {
+            add(NodeKind::Block);
+            for (Stmt* s: stmt->getStatements()) {
+                s->accept(this);
+            }
+        }
+
+    private:
+        uint64_t* nodes;
+};
+
+void Stats::countNodes(std::vector<Stmt*>& statements) {
+    NodeCounter counter{nodes};
+    counter.count(statements);
+}
+
+uint64_t Stats::totalNodes() const {
+    uint64_t total = 0;
+    for (uint64_t count: nodes) {
+        total += count;
+    }
+    return total;
+}
+
+void Stats::writeText(std::ostream& out) const {
+    out << std::left << std::setw(12) << "phase" << std::right << std::setw(12) << "ms";
+    if (ALLOCATIONS_COUNTED) {
+        out << std::setw(14) << "allocations" << std::setw(14) << "bytes";
+    }
+    out << "\n";
+    for (const PhaseStats& phase: phases) {
+        out << std::left << std::setw(12) << phase.name << std::right
+            << std::setw(12) << std::fixed << std::setprecision(3) << phase.seconds * 1000;
+        if (ALLOCATIONS_COUNTED) {
+            out << std::setw(14) << phase.allocations.count << std::setw(14) << phase.allocations.bytes;
+        }
+        out << "\n";
+    }
+    out << "\ntokens      " << tokens << "\n";
+    out << "statements  " << statements << "\n";
+    out << "dispatches  " << dispatches << "\n";
+    out << "\nnodes\n";
+    for (size_t i = 0; i < static_cast<size_t>(NodeKind::Count); i++) {
+        if (nodes[i] != 0) {
+            out << "  " << std::left << std::setw(16) << NODE_NAMES[i] << std::right << nodes[i] << "\n";
+        }
+    }
+}
+
+// Phase and node names are fixed identifiers, so nothing needs escaping.
+void Stats::writeJson(std::ostream& out) const {
+    out << "{\"phases\":[";
+    for (size_t i = 0; i < phases.size(); i++) {
+        const PhaseStats& phase = phases[i];
+        out << (i ? "," : "") << "{\"name\":\"" << phase.name << "\",\"seconds\":"
+            << std::setprecision(9) << phase.seconds;
+        if (ALLOCATIONS_COUNTED) {
+            out << ",\"allocations\":" << phase.allocations.count
+                << ",\"bytes\":" << phase.allocations.bytes;
+        }
+        out << "}";
+    }
+    out << "],\"tokens\":" << tokens
+        << ",\"statements\":" << statements
+        << ",\"dispatches\":" << dispatches
+        << ",\"nodes\":{";
+    for (size_t i = 0; i < static_cast<size_t>(NodeKind::Count); i++) {
+        out << (i ? "," : "") << "\"" << NODE_NAMES[i] << "\":" << nodes[i];
+    }
+    out << "}}\n";
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "expr.h"
+
+// Heap allocations made by the calling thread so far. Counted by the global
+// operator new that stats.cpp replaces when built with
+// SIMPLELANG_ALLOC_STATS defined; otherwise nothing is counted and --stats
+// leaves the allocation columns out. The hook costs every allocation in the
+// process, so it is off by default and never wanted in an embedding build.
+struct AllocationCount {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+#ifdef SIMPLELANG_ALLOC_STATS
+inline constexpr bool ALLOCATIONS_COUNTED = true;
+#else
+inline constexpr bool ALLOCATIONS_COUNTED = false;
+#endif
+
+AllocationCount threadAllocations();
+
+enum class NodeKind {
+    Literal, Unary, Binary, Variable, Assign, Call,
+    Expression, Print, Var, If, Block,
+    Count,
+};
+
+struct PhaseStats {
+    std::string name;
+    double seconds = 0;
+    AllocationCount allocations;
+};
+
+// Everything --stats reports for one run.
+struct Stats {
+    std::vector<PhaseStats> phases;
+    uint64_t tokens = 0;
+    uint64_t nodes[static_cast<size_t>(NodeKind::Count)] = {};
+    // Tree interpreter only.
+    uint64_t statements = 0;
+    uint64_t dispatches = 0;
+
+    // Adds every node of `statements` to `nodes`.
+    void countNodes(std::vector<Stmt*>& statements);
+    uint64_t totalNodes() const;
+
+    void writeText(std::ostream& out) const;
+    void writeJson(std::ostream& out) const;
+};
+
+// Records the wall time and allocations between construction and
+// destruction as one phase of `stats`. Does nothing if `stats` is null.
+class PhaseTimer {
+    public:
+        PhaseTimer(Stats* stats, const char* name) : stats{stats}, name{name} {
+            if (stats != nullptr) {
+                allocations = threadAllocations();
+                begin = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~PhaseTimer() {
+            if (stats != nullptr) {
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+                AllocationCount now = threadAllocations();
+                stats->phases.push_back(PhaseStats{name, elapsed.count(),
+                                                   {now.count - allocations.count, now.bytes - allocations.bytes}});
+            }
+        }
+
+        PhaseTimer(const PhaseTimer&) = delete;
+        PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    private:
+        Stats* stats;
+        const char* name;
+        AllocationCount allocations;
+        std::chrono::steady_clock::time_point begin;
+};
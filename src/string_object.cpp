@@ -0,0 +1,159 @@
+#include "string_object.h"
+#include <cstring>
+#include <vector>
+
+static constexpr size_t COLLECT_THRESHOLD = 1024;
+
+// Strings whose count has dropped to zero, or never left it, since the last
+// collect(). Whatever is left when the thread exits is freed then.
+struct StringHeap {
+    std::vector<StringObject*> zeroCount;
+
+    ~StringHeap() { sweep(); }
+
+    // Frees every string in zeroCount that still has no references, along
+    // with the halves of a rope that only it referenced. The caller has
+    // counted anything it still holds.
+    void sweep() {
+        std::vector<StringObject*> dead;
+        for (StringObject* object: zeroCount) {
+            object->pending = false;
+            if (object->refs == 0) {
+                dead.push_back(object);
+            }
+        }
+        zeroCount.clear();
+        while (!dead.empty()) {
+            StringObject* next = dead.back();
+            dead.pop_back();
+            for (const Value* half: {&next->left, &next->right}) {
+                if (half->isStringObject() && --half->asStringObject()->refs == 0) {
+                    dead.push_back(half->asStringObject());
+                }
+            }
+            delete next;
+        }
+    }
+};
+
+static thread_local StringHeap heap;
+
+StringObject* StringObject::allocate(size_t length) {
+    auto object = new StringObject{length};
+    object->pending = true;
+    heap.zeroCount.push_back(object);
+    return object;
+}
+
+void StringObject::releaseObject(StringObject* object) {
+    if (--object->refs == 0 && !object->pending) {
+        object->pending = true;
+        heap.zeroCount.push_back(object);
+    }
+}
+
+bool StringObject::collectionDue() {
+    return heap.zeroCount.size() >= COLLECT_THRESHOLD;
+}
+
+void StringObject::collect(const Value* roots, size_t count) {
+    if (heap.zeroCount.empty()) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        retain(roots[i]);
+    }
+    heap.sweep();
+    for (size_t i = 0; i < count; i++) {
+        release(roots[i]);
+    }
+}
+
+Value StringObject::make(std::string_view text) {
+    Value value = temporary(text);
+    retain(value);
+    return value;
+}
+
+Value StringObject::temporary(std::string_view text) {
+    if (text.size() <= Value::SHORT_MAX) {
+        return Value::shortString(text);
+    }
+    StringObject* object = allocate(text.size());
+    object->buffer = std::make_unique<char[]>(text.size());
+    std::memcpy(object->buffer.get(), text.data(), text.size());
+    object->chars = object->buffer.get();
+    return Value::string(object);
+}
+
+std::string_view Value::stringObjectView(StringObject* object) {
+    return object->view();
+}
+
+static size_t stringSize(const Value& value) {
+    return value.isStringObject() ? value.asStringObject()->size() : value.asString().size();
+}
+
+// Sizes are compared first so that unequal ropes are usually told apart
+// without being flattened.
+bool Value::stringsEqual(const Value& left, const Value& right) {
+    if (!left.isString() || !right.isString() || stringSize(left) != stringSize(right)) {
+        return false;
+    }
+    std::string_view a = left.asString();
+    std::string_view b = right.asString();
+    return a == b;
+}
+
+std::string_view StringObject::view() {
+    if (isRope()) {
+        flatten();
+    }
+    return std::string_view(chars, length);
+}
+
+// Walks the rope with an explicit stack, since a string built by appending
+// one piece at a time is a chain as deep as the number of pieces.
+void StringObject::flatten() {
+    buffer = std::make_unique<char[]>(length);
+    char* out = buffer.get();
+    std::vector<const Value*> parts{&right, &left};
+    while (!parts.empty()) {
+        const Value* part = parts.back();
+        parts.pop_back();
+        if (part->isStringObject() && part->asStringObject()->isRope()) {
+            StringObject* rope = part->asStringObject();
+            parts.push_back(&rope->right);
+            parts.push_back(&rope->left);
+            continue;
+        }
+        std::string_view text = part->asString();
+        std::memcpy(out, text.data(), text.size());
+        out += text.size();
+    }
+    chars = buffer.get();
+    release(left);
+    release(right);
+    left = Value::nil();
+    right = Value::nil();
+}
+
+Value concatStrings(const Value& left, const Value& right) {
+    size_t length = stringSize(left) + stringSize(right);
+
+    if (length <= StringObject::FLAT_MAX) {
+        char joined[StringObject::FLAT_MAX];
+        std::string_view a = left.asString();
+        std::string_view b = right.asString();
+        std::memcpy(joined, a.data(), a.size());
+        std::memcpy(joined + a.size(), b.data(), b.size());
+        return StringObject::temporary(std::string_view(joined, length));
+    }
+
+    StringObject* object = StringObject::allocate(length);
+    object->left = left;
+    object->right = right;
+    StringObject::retain(left);
+    StringObject::retain(right);
+    return Value::string(object);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include "value.h"
+
+// Heap string built at runtime. Short results of `+` live inline in the
+// Value; longer ones up to FLAT_MAX characters are copied into a flat
+// buffer; anything longer becomes a rope node that only keeps its two
+// halves. A rope is flattened in place, once, the first time its characters
+// are needed, so building a string from n pieces costs O(n) instead of
+// O(n^2).
+//
+// Reference counting is deferred: only references from variable slots and
+// from rope nodes are counted, never the temporaries an expression passes
+// around. A string whose count is zero sits in a per-thread table until
+// collect() is called at a point where the caller can name every temporary
+// still alive (the VM stack) or knows there are none (between statements).
+// Each string belongs to the thread that created it.
+class StringObject {
+    public:
+        static constexpr size_t FLAT_MAX = 64;
+
+        // A new runtime string that the caller holds one reference to, e.g.
+        // a host-supplied input. It stays valid across any number of runs
+        // and compiles until the caller passes it to release(). Short
+        // strings are stored inline and need no release, but calling it is
+        // harmless.
+        static Value make(std::string_view text);
+        // A new runtime string nothing holds a reference to, e.g. for a
+        // native function's result. It is only valid until the next
+        // collection, so it must be handed straight back to the script.
+        static Value temporary(std::string_view text);
+
+        size_t size() const { return length; }
+        bool isRope() const { return chars == nullptr; }
+
+        // Flattens a rope first.
+        std::string_view view();
+
+        static void retain(const Value& value) {
+            if (value.isStringObject()) value.asStringObject()->refs++;
+        }
+        static void release(const Value& value) {
+            if (value.isStringObject()) releaseObject(value.asStringObject());
+        }
+
+        // True once enough uncounted strings have piled up to be worth a
+        // collect().
+        static bool collectionDue();
+        // Frees every string with a zero count that is not one of `roots`.
+        static void collect(const Value* roots = nullptr, size_t count = 0);
+
+    private:
+        friend class Value;
+        friend struct StringHeap;
+        friend Value concatStrings(const Value& left, const Value& right);
+
+        StringObject(size_t length) : length{length} {}
+
+        static StringObject* allocate(size_t length);
+        static void releaseObject(StringObject* object);
+        void flatten();
+
+        uint32_t refs = 0;
+        bool pending = false;
+        size_t length;
+        // Null while this is a rope.
+        const char* chars = nullptr;
+        std::unique_ptr<char[]> buffer;
+        Value left;
+        Value right;
+};
+
+// `slot = value` for a variable slot, keeping the counts of the string it
+// held and the string it now holds.
+inline void storeValue(Value& slot, const Value& value) {
+    StringObject::retain(value);
+    StringObject::release(slot);
+    slot = value;
+}
+
+// `left + right` for two string Values.
+Value concatStrings(const Value& left, const Value& right);
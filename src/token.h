@@ -1,14 +1,14 @@
 #pragma once
 
-#include <string>
-#include <any>
+#include <cstdint>
+#include <string_view>
 
 enum TokenType {
     LeftParen, RightParen, LeftBrace, RightBrace, 
     Comma, Dot, Minus, Plus, Semicolon, Slash, Star, 
 
     Bang, BangEqual,
-    Equal, EqualEqual,); break;
+    Equal, EqualEqual,
      
     Greater, GreaterEqual,
     Less, LessEqual,
@@ -16,17 +16,37 @@ enum TokenType {
     Identifier, String, Number,
 
     And, Break, Class, Continue, Do, Else, ElseIf, 
-    False, Fun, For, If, In, Let, Nil, Or,/ right;
+    False, Fun, For, If, In, Let, Nil, Or,
 
     Print, Return, Super, Static, Struct, Switch, 
-t = (left < right)
+    True, This, Var, While,
+
     Eof, Unknown
 };
 
-struct Token {right == 
+struct Keyword {
+    std::string_view text;
+    TokenType type;
+};
+
+// Reserved words; the lexer builds its perfect-hash lookup table from this list.
+inline constexpr Keyword KEYWORDS[] = {
+    {"and", And}, {"break", Break}, {"class", Class}, {"continue", Continue},
+    {"do", Do}, {"else", Else}, {"elseif", ElseIf}, {"false", False},
+    {"fun", Fun}, {"for", For}, {"if", If}, {"in", In}, {"let", Let},
+    {"nil", Nil}, {"or", Or}, {"print", Print}, {"return", Return},
+    {"super", Super}, {"static", Static}, {"struct", Struct}, {"switch", Switch},
+    {"true", True}, {"this", This}, {"var", Var}, {"while", While},
+};
+
+// Plain value type: the lexeme is a view into the source buffer, which must
+// outlive every token and AST node built from it. Literal values are decoded
+// by the parser when it builds a LiteralExpr.
+struct Token {
     TokenType type;
-    std::string lexeme;
-    std::any literal;
+    uint32_t line;
+    std::string_view lexeme;
 
-    Token(TokenType type, std::string lexeme, std::any literal = nullptr) : type{type}, lexeme{lexeme}, literal{literal} {}
+    Token() : type{TokenType::Eof}, line{0} {}
+    Token(TokenType type, std::string_view lexeme, uint32_t line = 0) : type{type}, line{line}, lexeme{lexeme} {}
 };
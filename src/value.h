@@ -0,0 +1,148 @@
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include "intern.h"
+
+class StringObject;
+
+// Runtime value, NaN-boxed into 8 bytes.
+//
+// Any bit pattern that is not a quiet NaN with the QNAN bits set is a double.
+// Otherwise, with the sign bit clear, the low bits carry a tag (nil, false,
+// true) or a short string of up to SHORT_MAX characters stored in the value
+// itself. With the sign bit set they carry a pointer to either an interned
+// string, which lives forever, or, when the lowest bit is set, a StringObject
+// built at runtime (see string_object.h).
+//
+// Strings of up to SHORT_MAX characters are always stored inline and longer
+// literals are always interned, so two strings can only be equal with
+// different bits when at least one is a StringObject.
+//
+// Value is trivially copyable on purpose: it is passed and returned in
+// registers, and copying one never touches a reference count.
+class Value {
+    public:
+        static constexpr size_t SHORT_MAX = 5;
+
+        Value() : bits{QNAN | TAG_NIL} {}
+
+        static Value nil() { return Value{QNAN | TAG_NIL}; }
+        static Value boolean(bool b) { return Value{b ? QNAN | TAG_TRUE : QNAN | TAG_FALSE}; }
+        static Value number(double d) {
+            uint64_t bits;
+            std::memcpy(&bits, &d, sizeof(d));
+            return Value{bits};
+        }
+        // Inline when short, otherwise interned. Meant for literals and other
+        // long-lived text; runtime results go through concatStrings.
+        static Value string(std::string_view text) {
+            if (text.size() <= SHORT_MAX) {
+                return shortString(text);
+            }
+            return Value{SIGN_BIT | QNAN | reinterpret_cast<uint64_t>(internGlobal(text))};
+        }
+        static Value string(StringObject* object) {
+            return Value{SIGN_BIT | QNAN | reinterpret_cast<uint64_t>(object) | OBJECT_TAG};
+        }
+
+        bool isNumber() const { return (bits & QNAN) != QNAN; }
+        bool isNil() const { return bits == (QNAN | TAG_NIL); }
+        bool isBool() const { return (bits | 1) == (QNAN | TAG_TRUE); }
+        bool isString() const {
+            return (bits & (SIGN_BIT | QNAN)) == (SIGN_BIT | QNAN) || (bits & (SIGN_BIT | QNAN | SHORT)) == (QNAN | SHORT);
+        }
+        bool isShortString() const { return (bits & (SIGN_BIT | QNAN | SHORT)) == (QNAN | SHORT); }
+        bool isStringObject() const { return (bits & (SIGN_BIT | QNAN | OBJECT_TAG)) == (SIGN_BIT | QNAN | OBJECT_TAG); }
+
+        double asNumber() const {
+            double d;
+            std::memcpy(&d, &bits, sizeof(d));
+            return d;
+        }
+        bool asBool() const { return bits == (QNAN | TAG_TRUE); }
+        StringObject* asStringObject() const {
+            return reinterpret_cast<StringObject*>(bits & ~(SIGN_BIT | QNAN | OBJECT_TAG));
+        }
+        // A short string's characters live inside the Value, so the view is
+        // only valid while this Value is.
+        std::string_view asString() const & {
+            if (isShortString()) {
+                return std::string_view(reinterpret_cast<const char*>(&bits), (bits >> SHORT_LENGTH_SHIFT) & 7);
+            }
+            if (isStringObject()) {
+                return stringObjectView(asStringObject());
+            }
+            return reinterpret_cast<const InternedString*>(bits & ~(SIGN_BIT | QNAN))->view();
+        }
+        std::string_view asString() const && = delete;
+
+        bool isTruthy() const {
+            if (isNumber()) return asNumber() != 0;
+            if (isString()) return true;
+            return asBool();
+        }
+
+        bool operator==(const Value& other) const {
+            if (isNumber() && other.isNumber()) return asNumber() == other.asNumber();
+            if (bits == other.bits) return true;
+            return (isStringObject() || other.isStringObject()) && stringsEqual(*this, other);
+        }
+        bool operator!=(const Value& other) const { return !(*this == other); }
+
+    private:
+        friend class StringObject;
+        friend Value concatStrings(const Value& left, const Value& right);
+
+        explicit Value(uint64_t bits) : bits{bits} {}
+
+        // Characters go in the low bytes, which assumes a little-endian host.
+        static Value shortString(std::string_view text) {
+            uint64_t chars = 0;
+            std::memcpy(&chars, text.data(), text.size());
+            return Value{QNAN | SHORT | (static_cast<uint64_t>(text.size()) << SHORT_LENGTH_SHIFT) | chars};
+        }
+
+        static std::string_view stringObjectView(StringObject* object);
+        static bool stringsEqual(const Value& left, const Value& right);
+
+        static constexpr uint64_t SIGN_BIT = 0x8000000000000000;
+        static constexpr uint64_t QNAN = 0x7ffc000000000000;
+        static constexpr uint64_t SHORT = 0x0002000000000000;
+        static constexpr uint64_t SHORT_LENGTH_SHIFT = 40;
+        static constexpr uint64_t OBJECT_TAG = 1;
+        static constexpr uint64_t TAG_NIL = 1;
+        static constexpr uint64_t TAG_FALSE = 2;
+        static constexpr uint64_t TAG_TRUE = 3;
+
+        uint64_t bits;
+};
+
+static_assert(sizeof(Value) == 8, "Value must stay NaN-boxed into 8 bytes");
+
+// Shortest text that reads back as the same double. Integral values below
+// 2^53 are always written out in full rather than in exponent form.
+inline size_t formatNumber(char* buffer, size_t size, double number) {
+    std::to_chars_result result;
+    if (std::trunc(number) == number && std::fabs(number) < 9007199254740992.0) {
+        result = std::to_chars(buffer, buffer + size, number, std::chars_format::fixed);
+    } else {
+        result = std::to_chars(buffer, buffer + size, number);
+    }
+    return static_cast<size_t>(result.ptr - buffer);
+}
+
+inline std::ostream& operator<<(std::ostream& out, const Value& value) {
+    if (value.isNumber()) {
+        char buffer[32];
+        return out.write(buffer, static_cast<std::streamsize>(formatNumber(buffer, sizeof(buffer), value.asNumber())));
+    }
+    if (value.isString()) return out << value.asString();
+    if (value.isBool()) return out << (value.asBool() ? "true" : "false");
+    return out << "nil";
+}
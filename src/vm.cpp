@@ -0,0 +1,220 @@
+#include "vm.h"
+#include "operators.h"
+#include "string_object.h"
+#include <stdexcept>
+
+#if defined(__GNUC__)
+#define SL_COMPUTED_GOTO 1
+#define SL_NOINLINE __attribute__((noinline))
+#define SL_ALWAYS_INLINE __attribute__((always_inline)) inline
+#else
+#define SL_NOINLINE
+#define SL_ALWAYS_INLINE inline
+#endif
+
+VM::~VM() {
+    for (const Value& value: frame) {
+        StringObject::release(value);
+    }
+    StringObject::collect();
+}
+
+void VM::bind(uint32_t slot, Value value) {
+    if (frame.size() <= slot) {
+        frame.resize(slot + 1);
+    }
+    storeValue(frame[slot], value);
+}
+
+// Kept out of run() so the numeric paths do not pay for it. The stack holds
+// every string still in flight, so it is all a collection needs as roots.
+SL_NOINLINE Value* VM::pushConcat(Value* sp, Value left, Value right) {
+    *sp++ = concatStrings(left, right);
+    if (StringObject::collectionDue()) {
+        StringObject::collect(stack.data(), sp - stack.data());
+    }
+    return sp;
+}
+
+// `op` is one of the plain comparison opcodes. Plain and fused handlers all
+// go through here, so each instantiation inlines only its own operator.
+template <OpCode op>
+static SL_ALWAYS_INLINE bool compare(Value left, Value right) {
+    if constexpr (op == OpCode::Equal) {
+        return left == right;
+    } else if constexpr (op == OpCode::NotEqual) {
+        return left != right;
+    } else {
+        double l = numberOperand(left);
+        double r = numberOperand(right);
+        if constexpr (op == OpCode::Less) return l < r;
+        else if constexpr (op == OpCode::LessEqual) return l <= r;
+        else if constexpr (op == OpCode::Greater) return l > r;
+        else return l >= r;
+    }
+}
+
+// Stores `left op right` at sp and returns the new top, for any of the plain
+// binary opcodes Add through GreaterEqual.
+template <OpCode op>
+SL_ALWAYS_INLINE Value* VM::binary(Value* sp, Value left, Value right) {
+    if constexpr (op == OpCode::Add) {
+        if (!right.isNumber() && left.isString() && right.isString()) {
+            return pushConcat(sp, left, right);
+        }
+        *sp = Value::number(numberOperand(left) + numberOperand(right));
+    } else if constexpr (op == OpCode::Subtract) {
+        *sp = Value::number(numberOperand(left) - numberOperand(right));
+    } else if constexpr (op == OpCode::Multiply) {
+        *sp = Value::number(numberOperand(left) * numberOperand(right));
+    } else if constexpr (op == OpCode::Divide) {
+        double l = numberOperand(left);
+        double r = numberOperand(right);
+        if (r == 0)
+            throw std::runtime_error("right operand is 0");
+        *sp = Value::number(l / r);
+    } else {
+        *sp = Value::boolean(compare<op>(left, right));
+    }
+    return sp + 1;
+}
+
+void VM::run(const Chunk& chunk) {
+    stack.resize(chunk.maxStack + 1);
+    if (frame.size() < chunk.slots) {
+        frame.resize(chunk.slots);
+    }
+    Value* slots = frame.data();
+    const uint8_t* code = chunk.code.data();
+    const uint8_t* ip = code;
+    const Value* constants = chunk.constants.data();
+    Value* sp = stack.data();
+
+#define PUSH(value) (*sp++ = (value))
+#define POP() (*--sp)
+
+#ifdef SL_COMPUTED_GOTO
+    static void* const labels[] = {
+#define SL_OPCODE_LABEL(name) &&op_##name,
+        SL_OPCODES(SL_OPCODE_LABEL)
+#undef SL_OPCODE_LABEL
+    };
+#define DISPATCH() goto *labels[*ip++]
+#define CASE(name) op_##name:
+    DISPATCH();
+#else
+#define DISPATCH() break
+#define CASE(name) case OpCode::name:
+    for (;;) switch (static_cast<OpCode>(*ip++)) {
+#endif
+
+    CASE(Constant) {
+        PUSH(constants[readU32(ip)]);
+        ip += 4;
+        DISPATCH();
+    }
+    CASE(Nil) { PUSH(Value::nil()); DISPATCH(); }
+    CASE(True) { PUSH(Value::boolean(true)); DISPATCH(); }
+    CASE(False) { PUSH(Value::boolean(false)); DISPATCH(); }
+    CASE(Pop) { --sp; DISPATCH(); }
+    CASE(GetLocal) {
+        PUSH(slots[readU32(ip)]);
+        ip += 4;
+        DISPATCH();
+    }
+    CASE(SetLocal) {
+        storeValue(slots[readU32(ip)], sp[-1]);
+        ip += 4;
+        DISPATCH();
+    }
+    CASE(Negate) {
+        sp[-1] = Value::number(-numberOperand(sp[-1]));
+        DISPATCH();
+    }
+    // Every binary operator, plain and with each fused operand shape.
+#define SL_BINARY_CASES(name)                                                     \
+    CASE(name) {                                                                  \
+        sp = binary<OpCode::name>(sp - 2, sp[-2], sp[-1]);                        \
+        DISPATCH();                                                               \
+    }                                                                             \
+    CASE(name##LocalLocal) {                                                      \
+        sp = binary<OpCode::name>(sp, slots[readU32(ip)], slots[readU32(ip + 4)]); \
+        ip += 8;                                                                  \
+        DISPATCH();                                                               \
+    }                                                                             \
+    CASE(name##LocalConstant) {                                                   \
+        sp = binary<OpCode::name>(sp, slots[readU32(ip)], constants[readU32(ip + 4)]); \
+        ip += 8;                                                                  \
+        DISPATCH();                                                               \
+    }                                                                             \
+    CASE(name##ConstantLocal) {                                                   \
+        sp = binary<OpCode::name>(sp, constants[readU32(ip)], slots[readU32(ip + 4)]); \
+        ip += 8;                                                                  \
+        DISPATCH();                                                               \
+    }
+    SL_BINARY_OPCODES(SL_BINARY_CASES, )
+#undef SL_BINARY_CASES
+
+    // Comparisons fused with the JumpIfFalse of an if statement.
+#define SL_COMPARE_JUMP_CASES(name)                                                        \
+    CASE(name##JumpIfFalse) {                                                              \
+        sp -= 2;                                                                           \
+        ip = compare<OpCode::name>(sp[0], sp[1]) ? ip + 4 : code + readU32(ip);            \
+        DISPATCH();                                                                        \
+    }                                                                                      \
+    CASE(name##LocalLocalJumpIfFalse) {                                                    \
+        bool taken = !compare<OpCode::name>(slots[readU32(ip)], slots[readU32(ip + 4)]);  \
+        ip = taken ? code + readU32(ip + 8) : ip + 12;                                     \
+        DISPATCH();                                                                        \
+    }                                                                                      \
+    CASE(name##LocalConstantJumpIfFalse) {                                                 \
+        bool taken = !compare<OpCode::name>(slots[readU32(ip)], constants[readU32(ip + 4)]); \
+        ip = taken ? code + readU32(ip + 8) : ip + 12;                                     \
+        DISPATCH();                                                                        \
+    }                                                                                      \
+    CASE(name##ConstantLocalJumpIfFalse) {                                                 \
+        bool taken = !compare<OpCode::name>(constants[readU32(ip)], slots[readU32(ip + 4)]); \
+        ip = taken ? code + readU32(ip + 8) : ip + 12;                                     \
+        DISPATCH();                                                                        \
+    }
+    SL_COMPARE_OPCODES(SL_COMPARE_JUMP_CASES, )
+#undef SL_COMPARE_JUMP_CASES
+
+    CASE(Print) {
+        printValue(*out, POP());
+        DISPATCH();
+    }
+    CASE(Call) {
+        const Native& native = (*natives)[readU32(ip)];
+        uint32_t argc = readU32(ip + 4);
+        ip += 8;
+        sp -= argc;
+        *sp = native.function(sp, argc);
+        sp++;
+        DISPATCH();
+    }
+    CASE(Jump) {
+        ip = code + readU32(ip);
+        DISPATCH();
+    }
+    CASE(JumpIfFalse) {
+        if (POP().isTruthy()) {
+            ip += 4;
+        } else {
+            ip = code + readU32(ip);
+        }
+        DISPATCH();
+    }
+    CASE(Return) {
+        return;
+    }
+
+#ifndef SL_COMPUTED_GOTO
+    }
+#endif
+
+#undef PUSH
+#undef POP
+#undef DISPATCH
+#undef CASE
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include "chunk.h"
+#include "natives.h"
+#include "output.h"
+#include "value.h"
+
+// Stack machine executing a Chunk produced by the Compiler.
+class VM {
+    public:
+        VM(const Natives* natives = nullptr, OutputSink* out = nullptr)
+        : natives{natives}, out{out != nullptr ? out : &standardOutput()} {}
+        VM(const VM&) = delete;
+        VM& operator=(const VM&) = delete;
+        ~VM();
+
+        void run(const Chunk& chunk);
+
+        // Presets a variable slot, e.g. a host-supplied input.
+        void bind(uint32_t slot, Value value);
+
+    private:
+        Value* pushConcat(Value* sp, Value left, Value right);
+        template <OpCode op>
+        Value* binary(Value* sp, Value left, Value right);
+
+        const Natives* natives;
+        OutputSink* out;
+        std::vector<Value> stack;
+        std::vector<Value> frame;
+};
@@ -0,0 +1,101 @@
+// Embedding API tests.
+//
+// Build against the interpreter sources, e.g.
+//   g++ -std=c++17 -pthread -iquote src tests/engine_test.cpp $(ls src/*.cpp | grep -v main.cpp)
+//       -o simplelang-engine-test
+//
+// Exits non-zero and names the failing check on the first failure.
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "../src/cache.h"
+#include "../src/serialize.h"
+#include "../src/simplelang.h"
+#include "../src/string_object.h"
+
+static void check(bool condition, const char* what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        std::exit(1);
+    }
+}
+
+// A long host string must survive anything the engine does between runs,
+// including compiles that fold strings and runs that collect their own.
+static void longStringInputAcrossRuns() {
+    const std::string text = "a fairly long host string, well past the inline limit";
+    simplelang::Engine engine;
+    Value input = StringObject::make(text);
+    simplelang::Script script = engine.compile("print s; var t = s + s;", {"s"});
+
+    StringSink first;
+    engine.run(script, {input}, &first);
+    engine.compile("print \"a folded string literal \" + \"that is long enough to be counted\";");
+    StringSink second;
+    engine.run(script, {input}, &second);
+
+    check(first.str() == text, "first run prints the input");
+    check(second.str() == text, "second run prints the same input");
+    check(input.asString() == text, "the host's value is still intact");
+    StringObject::release(input);
+}
+
+static std::string imageFile(const std::string& directory, std::string_view source) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.slc",
+                  static_cast<unsigned long long>(simplelang::scriptKey(source, {})));
+    return directory + "/" + name;
+}
+
+// An image whose key matches a script but whose text does not, as after a
+// hash collision, must not be run in place of that script.
+static void imageForOtherSource() {
+    namespace fs = std::filesystem;
+    std::string directory = (fs::temp_directory_path() / "simplelang-engine-test").string();
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    std::string first = "print 1;";
+    std::string second = "print 2;";
+    {
+        Program program;
+        Resolver resolver;
+        buildProgram(program, first, resolver, simplelang::Backend::Tree);
+        ImageInfo info;
+        info.sourceKey = simplelang::scriptKey(second, {});
+        info.source = first;
+        std::ofstream file(imageFile(directory, second), std::ios::binary);
+        file << writeImage(program, info);
+    }
+
+    simplelang::Engine engine;
+    engine.setCacheDirectory(directory);
+    StringSink out;
+    engine.run(engine.compile(second), {}, &out);
+    check(out.str() == "2", "an image of different source text is ignored");
+    fs::remove_all(directory);
+}
+
+static void duplicateInputNames() {
+    simplelang::Engine engine;
+    bool threw = false;
+    try {
+        engine.compile("print a;", {"a", "a"});
+    } catch (std::runtime_error&) {
+        threw = true;
+    }
+    check(threw, "duplicate input names are rejected");
+}
+
+int main() {
+    longStringInputAcrossRuns();
+    imageForOtherSource();
+    duplicateInputNames();
+    std::cout << "ok" << std::endl;
+    return 0;
+}